@@ -0,0 +1,66 @@
+#pragma once
+#ifndef CONSTRAINT_COLORING_H
+#define CONSTRAINT_COLORING_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+/*
+    约束图着色
+    两个约束共享一个粒子就不能同时求解。贪心地给每个约束分配一个
+    两端粒子都还没用过的颜色，同一颜色内的约束互不相交，可以并行做 Gauss-Seidel。
+    颜色用 64 位掩码记录，超过 64 种颜色的约束放到最后一个串行批次里。
+*/
+struct ConstraintColoring {
+    static constexpr int MAX_COLORS = 64;
+
+    std::vector<int> order;      // 按颜色排序后的约束下标（约束表重排后仍是表中第 k 条约束原来的下标）
+    std::vector<int> colorStart; // 第 c 种颜色在 order 中的范围: [colorStart[c], colorStart[c + 1])
+    bool hasSerialBatch = false; // 最后一个批次是否需要串行求解
+
+    int numColors() const { return colorStart.empty() ? 0 : (int)colorStart.size() - 1; }
+
+    bool isSerial(int color) const { return hasSerialBatch && color == numColors() - 1; }
+
+    // pairs[i] 为第 i 个约束连接的两个粒子下标
+    void build(const std::vector<std::pair<int, int>>& pairs, int particleCount) {
+        std::vector<uint64_t> usedColors(particleCount, 0);
+        std::vector<int> color(pairs.size(), MAX_COLORS);
+        std::vector<int> count(MAX_COLORS + 1, 0);
+
+        for (size_t i = 0; i < pairs.size(); i++) {
+            int a = pairs[i].first;
+            int b = pairs[i].second;
+            uint64_t used = usedColors[a] | usedColors[b];
+            int c = 0;
+            while (c < MAX_COLORS && (used & (uint64_t(1) << c))) c++;
+            if (c < MAX_COLORS) {
+                usedColors[a] |= uint64_t(1) << c;
+                usedColors[b] |= uint64_t(1) << c;
+            }
+            color[i] = c;
+            count[c]++;
+        }
+
+        // 去掉空的颜色，计算每种颜色的起始位置
+        std::vector<int> remap(MAX_COLORS + 1, -1);
+        colorStart.clear();
+        colorStart.push_back(0);
+        for (int c = 0; c <= MAX_COLORS; c++) {
+            if (count[c] == 0) continue;
+            remap[c] = (int)colorStart.size() - 1;
+            colorStart.push_back(colorStart.back() + count[c]);
+        }
+        hasSerialBatch = count[MAX_COLORS] > 0;
+
+        std::vector<int> offset(colorStart.begin(), colorStart.end() - 1);
+        order.resize(pairs.size());
+        for (size_t i = 0; i < pairs.size(); i++) {
+            order[offset[remap[color[i]]]++] = (int)i;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef DISTANCE_CONSTRAINT_H
+#define DISTANCE_CONSTRAINT_H
+
+#include "Model.h"
+#include "ConstraintColoring.h"
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <utility>
+#include <algorithm>
+
+/*
+    距离约束表
+    Edge 里存的是两个 Vertex_H 指针和三角形下标，求解器只需要两个粒子下标、静止长度和柔度。
+    每种约束（边长 / 弯曲）各一张连续的表，每条 16 字节，加载时从 Edge 建立一次，
+    并按着色顺序重排，求解时按顺序流式读取，不再经过 Edge* -> Vertex_H* 两次间接访问。
+*/
+struct DistanceConstraint {
+    uint32_t i0;        // 粒子下标（ParticleState 中的位置）
+    uint32_t i1;
+    float restLength;   // 静止长度
+    float compliance;   // 柔度，alpha = compliance / dt^2
+};
+static_assert(sizeof(DistanceConstraint) == 16, "DistanceConstraint must stay 16 bytes");
+
+// 一遍约束求解中，各约束修正前的相对误差 |len - rest| / rest：最大值和平方和
+// 求解核算位移时本来就要算 len，顺便统计，不用再遍历一次约束表；rms 由调用方按约束总数计算
+struct ConstraintResidual {
+    float maxError = 0.0f;
+    double sumSquared = 0.0;
+
+    void add(float error) {
+        maxError = std::max(maxError, error);
+        sumSquared += double(error) * error;
+    }
+    void merge(const ConstraintResidual& other) {
+        maxError = std::max(maxError, other.maxError);
+        sumSquared += other.sumSquared;
+    }
+    float rms(size_t count) const { return count > 0 ? (float)std::sqrt(sumSquared / double(count)) : 0.0f; }
+};
+
+// 从 Edge 建立约束表，粒子下标取自 Vertex_H::index（ParticleState::build 之后有效）
+inline std::vector<DistanceConstraint> buildDistanceConstraints(const std::vector<Edge*>& edges, float compliance) {
+    std::vector<DistanceConstraint> constraints;
+    constraints.reserve(edges.size());
+    for (const Edge* e : edges) {
+        constraints.push_back({ (uint32_t)e->v0->index, (uint32_t)e->v1->index, e->lenght, compliance });
+    }
+    return constraints;
+}
+
+// 对约束图着色，并把约束表按颜色重排：重排后 coloring 的 [colorStart[c], colorStart[c + 1]) 直接是表中的下标
+inline void colorDistanceConstraints(std::vector<DistanceConstraint>& constraints, ConstraintColoring& coloring, int particleCount) {
+    std::vector<std::pair<int, int>> pairs;
+    pairs.reserve(constraints.size());
+    for (const DistanceConstraint& c : constraints) pairs.push_back({ (int)c.i0, (int)c.i1 });
+    coloring.build(pairs, particleCount);
+
+    std::vector<DistanceConstraint> sorted(constraints.size());
+    for (size_t k = 0; k < coloring.order.size(); k++) {
+        sorted[k] = constraints[coloring.order[k]];
+    }
+    constraints.swap(sorted);
+}
+
+#endif
@@ -0,0 +1,354 @@
+#pragma once
+#ifndef DISTANCE_KERNEL_H
+#define DISTANCE_KERNEL_H
+
+#include <glm/glm.hpp>
+#include "DistanceConstraint.h"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DISTANCE_KERNEL_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DISTANCE_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+/*
+    距离约束的 SIMD 求解核
+    约束表按颜色排好序，同一颜色内的约束没有共享粒子，所以一次可以并行处理
+    8 个 (AVX2) 或 4 个 (SSE / NEON) 约束，最后不足一组的用标量收尾。
+    位置数组按 float[3 * n] 访问（glm::vec3 是紧凑的 3 个 float）。
+    AVX2 在运行时检测；ARM64 总是有 NEON。SSE 没有 gather，逐个装载的开销抵消了
+    4 路计算的收益，实测不比标量快，所以不支持 AVX2 的 x86 默认用标量核（SSE 可手动指定）。
+    XPBD：每条约束有一个拉格朗日乘子 lambda[k]（和约束表下标相同），
+    dLambda = (-C - alpha * lambda) / (w0 + w1 + alpha)，位移为 w * dLambda * 梯度，lambda 累加 dLambda。
+    每个求解核顺便返回本次处理的约束在修正前的相对误差 |len - rest| / rest（最大值和平方和，见 ConstraintResidual），
+    最大值用来判断是否还需要继续迭代，平方和给 SimCounters 算 rms。
+*/
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 must be tightly packed");
+
+namespace DistanceKernel {
+
+enum class Isa { Scalar, SSE, AVX2, NEON };
+
+inline const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::SSE:  return "SSE";
+    case Isa::AVX2: return "AVX2";
+    case Isa::NEON: return "NEON";
+    default:        return "Scalar";
+    }
+}
+
+// 当前 CPU 支持的最宽指令集
+inline Isa detect() {
+#if defined(DISTANCE_KERNEL_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Isa::AVX2;
+    return Isa::Scalar;
+#elif defined(DISTANCE_KERNEL_NEON)
+    return Isa::NEON;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+// 求解 [begin, end) 范围内的约束，alpha = compliance * invDt2，返回修正前的相对误差
+inline ConstraintResidual solveScalar(float* pos, const float* invMass, const DistanceConstraint* c, float* lambda,
+                                      int begin, int end, float invDt2) {
+    ConstraintResidual residual;
+    for (int k = begin; k < end; k++) {
+        const DistanceConstraint& dc = c[k];
+        float* p0 = pos + 3 * dc.i0;
+        float* p1 = pos + 3 * dc.i1;
+        float w0 = invMass[dc.i0];
+        float w1 = invMass[dc.i1];
+        float w = w0 + w1;
+        if (w == 0.0f) continue; // 避免除以0
+
+        float dx = p0[0] - p1[0];
+        float dy = p0[1] - p1[1];
+        float dz = p0[2] - p1[2];
+        float len = std::sqrt(dx * dx + dy * dy + dz * dz);
+        if (len < 1e-6f) continue; // 避免除以0
+        if (dc.restLength > 0.0f) residual.add(std::abs(len - dc.restLength) / dc.restLength);
+
+        float alpha = dc.compliance * invDt2;
+        float dLambda = (dc.restLength - len - alpha * lambda[k]) / (w + alpha);
+        lambda[k] += dLambda;
+        float s = dLambda / len; // 位移 / ||Xi - Xj||
+        p0[0] += dx * s * w0; p0[1] += dy * s * w0; p0[2] += dz * s * w0;
+        p1[0] -= dx * s * w1; p1[1] -= dy * s * w1; p1[2] -= dz * s * w1;
+    }
+    return residual;
+}
+
+#if defined(DISTANCE_KERNEL_X86)
+
+#if defined(__GNUC__)
+__attribute__((target("avx2,fma")))
+inline ConstraintResidual solveAVX2(float* pos, const float* invMass, const DistanceConstraint* c, float* lambda,
+                                    int begin, int end, float invDt2) {
+    const __m256i toLanes = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);   // 连续存放的 lambda -> 转置后的 lane 顺序
+    const __m256i fromLanes = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7); // 反过来
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 eps = _mm256_set1_ps(1e-6f);
+    const __m256 invDt2V = _mm256_set1_ps(invDt2);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 maxErrorV = zero;
+    __m256 sumSquaredV = zero;
+    alignas(32) float out[6][8];
+    alignas(32) int id0[8];
+    alignas(32) int id1[8];
+
+    int k = begin;
+    for (; k + 8 <= end; k += 8) {
+        // 8 条 16 字节的约束正好是 4 个 __m256，4x4 转置得到 i0 / i1 / rest / compliance
+        // 转置后 lane 的顺序是约束 0 2 4 6 1 3 5 7，各 lane 互相独立，写回时用同样的顺序即可
+        const float* src = reinterpret_cast<const float*>(c + k);
+        __m256 r0 = _mm256_loadu_ps(src);
+        __m256 r1 = _mm256_loadu_ps(src + 8);
+        __m256 r2 = _mm256_loadu_ps(src + 16);
+        __m256 r3 = _mm256_loadu_ps(src + 24);
+        __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+        __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+        __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+        __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+        __m256i a = _mm256_castps_si256(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)));
+        __m256i b = _mm256_castps_si256(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)));
+        __m256 r = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 alphaV = _mm256_mul_ps(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)), invDt2V);
+        _mm256_store_si256((__m256i*)id0, a);
+        _mm256_store_si256((__m256i*)id1, b);
+        __m256i a3 = _mm256_add_epi32(_mm256_slli_epi32(a, 1), a); // 下标 * 3
+        __m256i b3 = _mm256_add_epi32(_mm256_slli_epi32(b, 1), b);
+
+        __m256 x0 = _mm256_i32gather_ps(pos, a3, 4);
+        __m256 y0 = _mm256_i32gather_ps(pos + 1, a3, 4);
+        __m256 z0 = _mm256_i32gather_ps(pos + 2, a3, 4);
+        __m256 x1 = _mm256_i32gather_ps(pos, b3, 4);
+        __m256 y1 = _mm256_i32gather_ps(pos + 1, b3, 4);
+        __m256 z1 = _mm256_i32gather_ps(pos + 2, b3, 4);
+        __m256 w0 = _mm256_i32gather_ps(invMass, a, 4);
+        __m256 w1 = _mm256_i32gather_ps(invMass, b, 4);
+
+        __m256 dx = _mm256_sub_ps(x0, x1);
+        __m256 dy = _mm256_sub_ps(y0, y1);
+        __m256 dz = _mm256_sub_ps(z0, z1);
+        __m256 len2 = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+        __m256 len = _mm256_sqrt_ps(len2);
+        __m256 w = _mm256_add_ps(w0, w1);
+        __m256 lam = _mm256_permutevar8x32_ps(_mm256_loadu_ps(lambda + k), toLanes);
+
+        __m256 dLambda = _mm256_div_ps(_mm256_fnmadd_ps(alphaV, lam, _mm256_sub_ps(r, len)), _mm256_add_ps(w, alphaV));
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(w, zero, _CMP_GT_OQ), _mm256_cmp_ps(len, eps, _CMP_GE_OQ));
+        __m256 error = _mm256_div_ps(_mm256_and_ps(_mm256_sub_ps(r, len), absMask), r);
+        error = _mm256_blendv_ps(zero, error, _mm256_and_ps(valid, _mm256_cmp_ps(r, zero, _CMP_GT_OQ)));
+        maxErrorV = _mm256_max_ps(maxErrorV, error);
+        sumSquaredV = _mm256_fmadd_ps(error, error, sumSquaredV);
+        dLambda = _mm256_blendv_ps(zero, dLambda, valid); // 无效的约束位移为 0
+        __m256 s = _mm256_blendv_ps(zero, _mm256_div_ps(dLambda, len), valid);
+        _mm256_storeu_ps(lambda + k, _mm256_permutevar8x32_ps(_mm256_add_ps(lam, dLambda), fromLanes));
+
+        __m256 s0 = _mm256_mul_ps(s, w0);
+        __m256 s1 = _mm256_mul_ps(s, w1);
+        _mm256_store_ps(out[0], _mm256_fmadd_ps(dx, s0, x0));
+        _mm256_store_ps(out[1], _mm256_fmadd_ps(dy, s0, y0));
+        _mm256_store_ps(out[2], _mm256_fmadd_ps(dz, s0, z0));
+        _mm256_store_ps(out[3], _mm256_fnmadd_ps(dx, s1, x1));
+        _mm256_store_ps(out[4], _mm256_fnmadd_ps(dy, s1, y1));
+        _mm256_store_ps(out[5], _mm256_fnmadd_ps(dz, s1, z1));
+
+        // AVX2 没有 scatter，逐个写回
+        for (int l = 0; l < 8; l++) {
+            float* p0 = pos + 3 * id0[l];
+            float* p1 = pos + 3 * id1[l];
+            p0[0] = out[0][l]; p0[1] = out[1][l]; p0[2] = out[2][l];
+            p1[0] = out[3][l]; p1[1] = out[4][l]; p1[2] = out[5][l];
+        }
+    }
+    alignas(32) float errors[8];
+    alignas(32) float squares[8];
+    _mm256_store_ps(errors, maxErrorV);
+    _mm256_store_ps(squares, sumSquaredV);
+    ConstraintResidual residual = solveScalar(pos, invMass, c, lambda, k, end, invDt2);
+    for (int l = 0; l < 8; l++) {
+        residual.maxError = std::max(residual.maxError, errors[l]);
+        residual.sumSquared += squares[l];
+    }
+    return residual;
+}
+#endif
+
+inline ConstraintResidual solveSSE(float* pos, const float* invMass, const DistanceConstraint* c, float* lambda,
+                                   int begin, int end, float invDt2) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 eps = _mm_set1_ps(1e-6f);
+    const __m128 invDt2V = _mm_set1_ps(invDt2);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 maxErrorV = zero;
+    __m128 sumSquaredV = zero;
+    alignas(16) float in[10][4];
+    alignas(16) float out[6][4];
+
+    int k = begin;
+    for (; k + 4 <= end; k += 4) {
+        for (int l = 0; l < 4; l++) {
+            const DistanceConstraint& dc = c[k + l];
+            const float* p0 = pos + 3 * dc.i0;
+            const float* p1 = pos + 3 * dc.i1;
+            in[0][l] = p0[0]; in[1][l] = p0[1]; in[2][l] = p0[2];
+            in[3][l] = p1[0]; in[4][l] = p1[1]; in[5][l] = p1[2];
+            in[6][l] = invMass[dc.i0];
+            in[7][l] = invMass[dc.i1];
+            in[8][l] = dc.restLength;
+            in[9][l] = dc.compliance;
+        }
+        __m128 x0 = _mm_load_ps(in[0]), y0 = _mm_load_ps(in[1]), z0 = _mm_load_ps(in[2]);
+        __m128 x1 = _mm_load_ps(in[3]), y1 = _mm_load_ps(in[4]), z1 = _mm_load_ps(in[5]);
+        __m128 w0 = _mm_load_ps(in[6]), w1 = _mm_load_ps(in[7]);
+        __m128 r = _mm_load_ps(in[8]);
+        __m128 alphaV = _mm_mul_ps(_mm_load_ps(in[9]), invDt2V);
+
+        __m128 dx = _mm_sub_ps(x0, x1);
+        __m128 dy = _mm_sub_ps(y0, y1);
+        __m128 dz = _mm_sub_ps(z0, z1);
+        __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        __m128 w = _mm_add_ps(w0, w1);
+        __m128 lam = _mm_loadu_ps(lambda + k);
+
+        __m128 dLambda = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(r, len), _mm_mul_ps(alphaV, lam)), _mm_add_ps(w, alphaV));
+        __m128 valid = _mm_and_ps(_mm_cmpgt_ps(w, zero), _mm_cmpge_ps(len, eps));
+        __m128 error = _mm_div_ps(_mm_and_ps(_mm_sub_ps(r, len), absMask), r);
+        error = _mm_and_ps(_mm_and_ps(valid, _mm_cmpgt_ps(r, zero)), error);
+        maxErrorV = _mm_max_ps(maxErrorV, error);
+        sumSquaredV = _mm_add_ps(sumSquaredV, _mm_mul_ps(error, error));
+        dLambda = _mm_and_ps(valid, dLambda); // 无效的约束位移为 0
+        __m128 s = _mm_and_ps(valid, _mm_div_ps(dLambda, len));
+        _mm_storeu_ps(lambda + k, _mm_add_ps(lam, dLambda));
+
+        __m128 s0 = _mm_mul_ps(s, w0);
+        __m128 s1 = _mm_mul_ps(s, w1);
+        _mm_store_ps(out[0], _mm_add_ps(x0, _mm_mul_ps(dx, s0)));
+        _mm_store_ps(out[1], _mm_add_ps(y0, _mm_mul_ps(dy, s0)));
+        _mm_store_ps(out[2], _mm_add_ps(z0, _mm_mul_ps(dz, s0)));
+        _mm_store_ps(out[3], _mm_sub_ps(x1, _mm_mul_ps(dx, s1)));
+        _mm_store_ps(out[4], _mm_sub_ps(y1, _mm_mul_ps(dy, s1)));
+        _mm_store_ps(out[5], _mm_sub_ps(z1, _mm_mul_ps(dz, s1)));
+
+        for (int l = 0; l < 4; l++) {
+            float* p0 = pos + 3 * c[k + l].i0;
+            float* p1 = pos + 3 * c[k + l].i1;
+            p0[0] = out[0][l]; p0[1] = out[1][l]; p0[2] = out[2][l];
+            p1[0] = out[3][l]; p1[1] = out[4][l]; p1[2] = out[5][l];
+        }
+    }
+    alignas(16) float errors[4];
+    alignas(16) float squares[4];
+    _mm_store_ps(errors, maxErrorV);
+    _mm_store_ps(squares, sumSquaredV);
+    ConstraintResidual residual = solveScalar(pos, invMass, c, lambda, k, end, invDt2);
+    for (int l = 0; l < 4; l++) {
+        residual.maxError = std::max(residual.maxError, errors[l]);
+        residual.sumSquared += squares[l];
+    }
+    return residual;
+}
+
+#endif // DISTANCE_KERNEL_X86
+
+#if defined(DISTANCE_KERNEL_NEON)
+inline ConstraintResidual solveNEON(float* pos, const float* invMass, const DistanceConstraint* c, float* lambda,
+                                    int begin, int end, float invDt2) {
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t eps = vdupq_n_f32(1e-6f);
+    const float32x4_t invDt2V = vdupq_n_f32(invDt2);
+    float32x4_t maxErrorV = zero;
+    float32x4_t sumSquaredV = zero;
+    float in[10][4];
+    float out[6][4];
+
+    int k = begin;
+    for (; k + 4 <= end; k += 4) {
+        for (int l = 0; l < 4; l++) {
+            const DistanceConstraint& dc = c[k + l];
+            const float* p0 = pos + 3 * dc.i0;
+            const float* p1 = pos + 3 * dc.i1;
+            in[0][l] = p0[0]; in[1][l] = p0[1]; in[2][l] = p0[2];
+            in[3][l] = p1[0]; in[4][l] = p1[1]; in[5][l] = p1[2];
+            in[6][l] = invMass[dc.i0];
+            in[7][l] = invMass[dc.i1];
+            in[8][l] = dc.restLength;
+            in[9][l] = dc.compliance;
+        }
+        float32x4_t x0 = vld1q_f32(in[0]), y0 = vld1q_f32(in[1]), z0 = vld1q_f32(in[2]);
+        float32x4_t x1 = vld1q_f32(in[3]), y1 = vld1q_f32(in[4]), z1 = vld1q_f32(in[5]);
+        float32x4_t w0 = vld1q_f32(in[6]), w1 = vld1q_f32(in[7]);
+        float32x4_t r = vld1q_f32(in[8]);
+        float32x4_t alphaV = vmulq_f32(vld1q_f32(in[9]), invDt2V);
+
+        float32x4_t dx = vsubq_f32(x0, x1);
+        float32x4_t dy = vsubq_f32(y0, y1);
+        float32x4_t dz = vsubq_f32(z0, z1);
+        float32x4_t len = vsqrtq_f32(vfmaq_f32(vfmaq_f32(vmulq_f32(dx, dx), dy, dy), dz, dz));
+        float32x4_t w = vaddq_f32(w0, w1);
+        float32x4_t lam = vld1q_f32(lambda + k);
+
+        float32x4_t dLambda = vdivq_f32(vfmsq_f32(vsubq_f32(r, len), alphaV, lam), vaddq_f32(w, alphaV));
+        uint32x4_t valid = vandq_u32(vcgtq_f32(w, zero), vcgeq_f32(len, eps));
+        float32x4_t error = vdivq_f32(vabdq_f32(r, len), r);
+        error = vbslq_f32(vandq_u32(valid, vcgtq_f32(r, zero)), error, zero);
+        maxErrorV = vmaxq_f32(maxErrorV, error);
+        sumSquaredV = vfmaq_f32(sumSquaredV, error, error);
+        dLambda = vbslq_f32(valid, dLambda, zero); // 无效的约束位移为 0
+        float32x4_t s = vbslq_f32(valid, vdivq_f32(dLambda, len), zero);
+        vst1q_f32(lambda + k, vaddq_f32(lam, dLambda));
+
+        float32x4_t s0 = vmulq_f32(s, w0);
+        float32x4_t s1 = vmulq_f32(s, w1);
+        vst1q_f32(out[0], vfmaq_f32(x0, dx, s0));
+        vst1q_f32(out[1], vfmaq_f32(y0, dy, s0));
+        vst1q_f32(out[2], vfmaq_f32(z0, dz, s0));
+        vst1q_f32(out[3], vfmsq_f32(x1, dx, s1));
+        vst1q_f32(out[4], vfmsq_f32(y1, dy, s1));
+        vst1q_f32(out[5], vfmsq_f32(z1, dz, s1));
+
+        for (int l = 0; l < 4; l++) {
+            float* p0 = pos + 3 * c[k + l].i0;
+            float* p1 = pos + 3 * c[k + l].i1;
+            p0[0] = out[0][l]; p0[1] = out[1][l]; p0[2] = out[2][l];
+            p1[0] = out[3][l]; p1[1] = out[4][l]; p1[2] = out[5][l];
+        }
+    }
+    ConstraintResidual residual = solveScalar(pos, invMass, c, lambda, k, end, invDt2);
+    residual.maxError = std::max(residual.maxError, vmaxvq_f32(maxErrorV));
+    residual.sumSquared += vaddvq_f32(sumSquaredV);
+    return residual;
+}
+#endif // DISTANCE_KERNEL_NEON
+
+// 按 isa 选择求解核，[begin, end) 内的约束必须两两没有共享粒子；返回修正前的相对误差
+inline ConstraintResidual solve(Isa isa, float* pos, const float* invMass, const DistanceConstraint* c, float* lambda,
+                                int begin, int end, float invDt2) {
+    switch (isa) {
+#if defined(DISTANCE_KERNEL_X86)
+#if defined(__GNUC__)
+    case Isa::AVX2: return solveAVX2(pos, invMass, c, lambda, begin, end, invDt2);
+#endif
+    case Isa::SSE:  return solveSSE(pos, invMass, c, lambda, begin, end, invDt2);
+#endif
+#if defined(DISTANCE_KERNEL_NEON)
+    case Isa::NEON: return solveNEON(pos, invMass, c, lambda, begin, end, invDt2);
+#endif
+    default:        return solveScalar(pos, invMass, c, lambda, begin, end, invDt2);
+    }
+}
+
+} // namespace DistanceKernel
+
+#endif
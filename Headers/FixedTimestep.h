@@ -0,0 +1,47 @@
+#pragma once
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+/*
+    固定步长的时间累加器
+    墙上时间累加起来，每攒够一个 step 就走一步模拟，模拟的 dt 永远是 step，不随帧率变化。
+    一次最多走 maxStepsPerFrame 步：机器跟不上时丢掉多余的时间（模拟变慢），
+    而不是让下一帧补更多步、更慢、再补更多步。
+    alpha() 是累加器里剩下的不足一步的部分，用来在上一步和当前步之间插值显示。
+*/
+class FixedTimestep {
+public:
+    float step;                 // 固定的模拟步长（秒）
+    int maxStepsPerFrame = 4;   // 每次 advance 最多走几步
+    long long droppedSteps = 0; // 因为超过上限被丢掉的步数（累计）
+
+    explicit FixedTimestep(float step = 1.0f / 60.0f) : step(step) {}
+
+    // 加上经过的墙上时间，返回这次要走的步数
+    int advance(float elapsed) {
+        accumulator += elapsed;
+        int steps = (int)(accumulator / step);
+        if (steps > maxStepsPerFrame) {
+            droppedSteps += steps - maxStepsPerFrame;
+            steps = maxStepsPerFrame;
+            accumulator = 0.0; // 丢掉积压的时间，不再追赶
+        }
+        else {
+            accumulator -= steps * (double)step;
+        }
+        return steps;
+    }
+
+    // 累加器中剩余时间占一步的比例，[0, 1)
+    float alpha() const { return (float)(accumulator / step); }
+
+    // 距离下一步还差多少时间（秒）
+    float timeToNextStep() const { return (float)(step - accumulator); }
+
+    void reset() { accumulator = 0.0; }
+
+private:
+    double accumulator = 0.0;
+};
+
+#endif
@@ -2,309 +2,215 @@
 #ifndef HASH_H
 #define HASH_H
 
-#include <glad/glad.h>
-
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Mesh.h"
 
 #include <vector>
-
-struct Cell{
-    int count = 0;
-    std::vector<Vertex_H*> particles;
-};
-
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <omp.h>
+
+/*
+    空间哈希（计数排序，OpenMP 并行）
+    1. clear:              cellStart 清零
+    2. insertParticles:    并行统计每个 cell 的粒子数量（原子加）
+    3. partialSum:         并行前缀和，cellStart[i] = 前 0 ~ i 个 cell 的粒子总数
+    4. insertParticleMap:  并行写入 cellEntries（原子减），写完后 cell i 的粒子为 cellEntries[cellStart[i], cellStart[i + 1])
+    所有数组在构造时分配好，每帧重建只是几次线性遍历，不再分配内存。
+    cellEntries 里存的是粒子下标（ParticleState 中的位置），不是指针。
+*/
 class Hash{
     int tableSize;
-    std::vector<Cell> cellCount;
-    float hashing = 1.5f;
-
-    vector<Vertex_H*> particleMap;
-    vector<Vertex_H*> queryParticles; // 备选碰撞粒子集合
-    const std::vector<Vertex_H*>* allParticles = nullptr;
+    float hashing = 1.5f; // cell 的边长
 
-    int querySize = 0; 
-
-    // ⬇️ 新增：静态粒子集合指针
-    const std::unordered_set<Vertex_H*>* staticParticles;
+    std::vector<int> cellStart;   // tableSize + 1
+    std::vector<int> cellEntries; // 按 cell 排好序的粒子下标
+    std::vector<int> blockSums;   // 并行前缀和：每个线程负责的区间之和
+    std::vector<std::vector<int>> visitedBuckets; // 每个线程一次查询中已经访问过的桶
 
 public:
-    vector<int> firstAdjId;           // index: 粒子在 particles的位置， value: 该粒子有几个产生碰撞的粒子
-    vector<int> adjIds;               // index: 
-    // Hash(int particlesSize){
-    //     this->tableSize = particlesSize * 2 + 1;
-    //     cellCount.resize(tableSize + 1);
-    //     particleMap.resize(particlesSize);
-    // }
-
-    Hash(int particleCount, const std::unordered_set<Vertex_H*>* statics = nullptr)
-        : staticParticles(statics)
+    vector<int> firstAdjId;           // index: 粒子下标， [firstAdjId[i], firstAdjId[i + 1]) 为它在 adjIds 中的邻接粒子
+    vector<int> adjIds;               // 邻接粒子下标（对称：j 在 i 的表中，i 也在 j 的表中）
+
+    Hash(int particleCount)
     {
-        tableSize = particleCount * 5;
-        cellCount.resize(tableSize + 1);
-        particleMap.resize(particleCount);
-        queryParticles.resize(particleCount);
-        firstAdjId.resize(particleCount + 1, -1);
-        adjIds.resize(particleCount * 10, -1); // 假设每个粒子最多有10个邻接粒子
+        tableSize = std::max(particleCount * 2, 1);
+        cellStart.resize(tableSize + 1, 0);
+        cellEntries.resize(particleCount);
+        blockSums.resize(omp_get_max_threads() + 1, 0);
+        visitedBuckets.resize(omp_get_max_threads());
+        for (auto& v : visitedBuckets) v.reserve(64);
+        firstAdjId.resize(particleCount + 1, 0);
+        adjIds.resize(particleCount * 20, -1); // 假设每个粒子最多有20个邻接粒子
     }
 
-    // 计数 + 链表
-    void insertParticles(const vector<Vertex_H*> &vertices){
-        allParticles = &vertices; // 保存指向粒子集合的指针
+    void clear() {
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+    }
 
-        for(unsigned int i = 0; i < vertices.size(); i++){
-            int index = hashPos(vertices[i]->Position);
-            if(index >= 0 && index < cellCount.size()){
-                cellCount[index].count += 1;
-                cellCount[index].particles.push_back(vertices[i]);
-            }
+    // 计数
+    void insertParticles(const std::vector<glm::vec3>& positions){
+        int n = (int)positions.size();
+        #pragma omp parallel for schedule(static) if(n > 4096)
+        for(int i = 0; i < n; i++){
+            int h = hashPos(positions[i]);
+            #pragma omp atomic
+            cellStart[h]++;
         }
     }
 
     void partialSum(){
-        int value = 0;
-        for(unsigned int i = 0; i <= tableSize; i++){
-            value += cellCount[i].count;
-            cellCount[i].count = value;
-        }
+        parallelPrefixSum(cellStart.data(), tableSize + 1);
     }
 
-    // 第 i 个cell 为 前 0 ~ i-1 个cell中所有粒子的总和
-    int checkParticles(int index){
-        return cellCount[index + 1].count - cellCount[index].count;
+    // 原子减写入，写完后 cellStart[i] 正好是 cell i 的起始位置
+    // 多线程写入时同一个 cell 内的顺序不确定，排序后保证结果可复现
+    void insertParticleMap(const std::vector<glm::vec3>& positions) {
+        int n = (int)positions.size();
+        bool parallel = n > 4096 && omp_get_max_threads() > 1;
+        #pragma omp parallel for schedule(static) if(parallel)
+        for(int i = n - 1; i >= 0; i--){
+            int h = hashPos(positions[i]);
+            int slot;
+            #pragma omp atomic capture
+            slot = --cellStart[h];
+            cellEntries[slot] = i;
+        }
+        if(!parallel) return;
+
+        #pragma omp parallel for schedule(static)
+        for(int h = 0; h < tableSize; h++){
+            int start = cellStart[h];
+            int end = cellStart[h + 1];
+            if(end - start > 1) std::sort(cellEntries.begin() + start, cellEntries.begin() + end);
+        }
     }
 
-    // void insertParticleMap(){
-    //     for(unsigned int i = 1; i < cellCount.size(); i++){
-    //         int num = cellCount[i].count - cellCount[i - 1].count;
-    //         if(num != 0){
-    //             for(unsigned int j = cellCount[i].count; j > cellCount[i - 1].count; j--){
-    //                 cellCount[i].count = cellCount[i].count - 1;
-    //                 int index = cellCount[i].count; // particleMap的下标
-    //                 particleMap[index] = cellCount[i].particles.back(); // 将list最顶部的指针保存到particleMap中
-    //                 cellCount[i].particles.pop_back(); // 移除list最顶部的指针
-    //             }
-    //         }
-    //     }
-    // }
-
-    void insertParticleMap() {
-        int writeIndex = 0;
-    
-        for (int i = 0; i < cellCount.size(); ++i) {
-            if(cellCount[i].count == 0) continue; // 如果没有粒子，跳过
-            for (Vertex_H* p : cellCount[i].particles) {
-                if (writeIndex < particleMap.size()) {
-                    particleMap[writeIndex++] = p;
-                } else {
-                    std::cout << "[Error] particleMap overflow at index " << writeIndex << std::endl;
-                    break;
-                }
+    // 并行前缀和（包含自身）：a[i] = a[0] + ... + a[i]
+    // 每个线程先算自己区间的前缀和，再加上前面所有区间的总和
+    void parallelPrefixSum(int* a, int n){
+        if(n < 16384 || omp_get_max_threads() == 1){
+            int value = 0;
+            for(int i = 0; i < n; i++){
+                value += a[i];
+                a[i] = value;
             }
-            cellCount[i].particles.clear(); // optional: 清理粒子链表
+            return;
         }
-    }
 
+        #pragma omp parallel
+        {
+            int t = omp_get_thread_num();
+            int numThreads = omp_get_num_threads();
+            int begin = (int)((long long)n * t / numThreads);
+            int end = (int)((long long)n * (t + 1) / numThreads);
+
+            int value = 0;
+            for(int i = begin; i < end; i++){
+                value += a[i];
+                a[i] = value;
+            }
+            blockSums[t + 1] = value;
 
+            #pragma omp barrier
+            #pragma omp single
+            {
+                blockSums[0] = 0;
+                for(int k = 1; k <= numThreads; k++) blockSums[k] += blockSums[k - 1];
+            }
 
-    int64_t hashPos(glm::vec3 pos){
-        int x = static_cast<int>(floor(pos.x / hashing));
-        int y = static_cast<int>(floor(pos.y / hashing));
-        int z = static_cast<int>(floor(pos.z / hashing));
-        int64_t hash = (int64_t(x) * 92837111) ^ (int64_t(y) * 689287499) ^ (int64_t(z) * 283923481);
-        
-        return std::abs(hash) % tableSize;
+            int offset = blockSums[t];
+            if(offset != 0){
+                for(int i = begin; i < end; i++) a[i] += offset;
+            }
+        }
     }
 
-    void queryAndCollideAll(float radius){
-        for(Vertex_H *p : particleMap){
-            if(p)
-                queryAndCollide(*p, radius);
-        }
+    int hashCoords(int x, int y, int z){
+        int64_t hash = (int64_t(x) * 92837111) ^ (int64_t(y) * 689287499) ^ (int64_t(z) * 283923481);
+        return (int)(std::abs(hash) % tableSize);
     }
 
-    // void queryAndCollide(Vertex_H &particle, float radius) {
-    //     glm::vec3 pos = particle.Position;
-    //     int x = static_cast<int>(floor(pos.x / hashing));
-    //     int y = static_cast<int>(floor(pos.y / hashing));
-    //     int z = static_cast<int>(floor(pos.z / hashing));
-
-    //     int r = static_cast<int>(ceil(radius / hashing)); // 半径范围能影响几个 cell
-
-    //     for (int dx = -r; dx <= r; dx++) {
-    //         for (int dy = -r; dy <= r; dy++) {
-    //             for (int dz = -r; dz <= r; dz++) {
-    //                 int64_t hx = int64_t(x + dx) * 92837111;
-    //                 int64_t hy = int64_t(y + dy) * 689287499;
-    //                 int64_t hz = int64_t(z + dz) * 283923481;
-
-    //                 int64_t h = (hx ^ hy ^ hz);
-    //                 int index = static_cast<int>(std::abs(h) % tableSize);
-
-    //                 int start = (index == 0) ? 0 : cellCount[index - 1].count;
-    //                 int end = cellCount[index].count;
-
-    //                 for (int i = start; i < end; i++) {
-    //                     Vertex_H *other = particleMap[i];
-    //                     if (&particle == other) continue;
-
-    //                     float dist2 = glm::length(particle.Position - other->Position);
-    //                     if (dist2 < radius * radius) {
-    //                         // 碰撞响应：如反弹、拉开位置、计算力等等
-    //                         glm::vec3 normal = glm::normalize(particle.Position - other->Position);
-    //                         float overlap = radius - sqrt(dist2);
-    //                         particle.Position += 0.5f * overlap * normal;
-    //                         other->Position  -= 0.5f * overlap * normal;
-    //                     }
-    //                 }
-    //             }
-    //         }
-    //     }
-    // }
-
-    void queryAndCollide(Vertex_H &particle, float radius) {
-        glm::vec3 pos = particle.Position;
-        int x = static_cast<int>(floor(pos.x / hashing));
-        int y = static_cast<int>(floor(pos.y / hashing));
-        int z = static_cast<int>(floor(pos.z / hashing));
-
-        int r = static_cast<int>(ceil(radius / hashing)); // 搜索邻域
-
-        for (int dx = -r; dx <= r; dx++) {
-            for (int dy = -r; dy <= r; dy++) {
-                for (int dz = -r; dz <= r; dz++) {
-                    int64_t hx = int64_t(x + dx) * 92837111;
-                    int64_t hy = int64_t(y + dy) * 689287499;
-                    int64_t hz = int64_t(z + dz) * 283923481;
-                    int64_t h = hx ^ hy ^ hz;
-                    int index = static_cast<int>(std::abs(h) % tableSize);
-
-                    if (index < 0 || index >= (int)cellCount.size()) continue;
-
-                    int start = (index == 0) ? 0 : cellCount[index - 1].count;
-                    int end = cellCount[index].count;
-
-                    if (start < 0 || end > (int)particleMap.size()) continue;
-
-                    for (int i = start; i < end; ++i) {
-                        Vertex_H* other = particleMap[i];
-                        if (!other || &particle == other) continue; // 空指针保护 & 自身跳过
-
-                        glm::vec3 diff = particle.Position - other->Position;
-                        float dist2 = glm::dot(diff, diff);
-                        if (dist2 < radius * radius && dist2 > 1e-8f) {
-                            //glm::vec3 normal = glm::normalize(diff);
-                            // float overlap = radius - sqrt(dist2);
-                            
-                            // float correction = std::min(overlap * 0.5f, 0.01f);
-
-                            // particle.Position += 0.5f * overlap * normal;
-                            // other->Position  -= 0.5f * overlap * normal;
-
-                            // particle.Position += correction * normal;
-                            // other->Position  -= correction * normal;
-
-                            glm::vec3 normal = glm::normalize(diff);
-                            float overlap = radius - sqrt(dist2);
-                            float maxMove = 0.1f;
-                            float correction = std::min(overlap, maxMove);
-
-                            if (staticParticles && staticParticles->count(other)) {
-                                // ⬅️ other 是静态粒子，只推 particle
-                                particle.Position += correction * normal;
-                            } else {
-                                // ⬅️ 普通粒子对碰撞
-                                particle.Position += 0.5f * correction * normal;
-                                other->Position  -= 0.5f * correction * normal;
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    int cellCoord(float v){
+        return static_cast<int>(std::floor(v / hashing));
     }
 
-    void clear() {
-        for (auto& cell : cellCount) {
-            cell.count = 0;
-            cell.particles.clear();
-        }
+    int hashPos(const glm::vec3& pos){
+        return hashCoords(cellCoord(pos.x), cellCoord(pos.y), cellCoord(pos.z));
     }
 
-    void queryAll(float maxDist){
-        int num = 0;
+    // 建立邻接表 (CSR)：粒子 i 的邻接粒子为 adjIds[firstAdjId[i], firstAdjId[i + 1])
+    // 两遍并行：第一遍统计每个粒子的邻接数量，前缀和得到起始位置，第二遍写入
+    // 每对粒子在双方的表中各出现一次，碰撞求解时每个粒子只需要写自己的位置
+    void queryAll(const std::vector<glm::vec3>& positions, float maxDist){
         float maxDist2 = maxDist * maxDist;
-
-        // 保证 firstAdjId 足够大
-        if (firstAdjId.size() < particleMap.size() + 1) {
-            firstAdjId.resize(particleMap.size() + 1, -1);
-        }
-        // 保证 adjIds 有初始空间
-        if (adjIds.size() < particleMap.size() * 10) { // 8是经验值，可根据实际调整
-            adjIds.resize(particleMap.size() * 10);
+        int n = (int)positions.size();
+
+        // 1. 计数，粒子 i 的数量先放在 firstAdjId[i + 1]
+        firstAdjId[0] = 0;
+        #pragma omp parallel for schedule(dynamic, 256) if(n > 1024)
+        for(int id0 = 0; id0 < n; id0++){
+            int count = 0;
+            query(positions, id0, maxDist, [&](int id1) {
+                if(id1 == id0) return;                   // 跳过自己
+                glm::vec3 diff = positions[id0] - positions[id1];
+                if(glm::dot(diff, diff) > maxDist2) return; // 如果距离大于 maxDist，则跳过
+                count++;
+            });
+            firstAdjId[id0 + 1] = count;
         }
-        
-        for(int i = 0; i < particleMap.size(); i++){
-            int id0 = i;
-            firstAdjId[id0] = num; // 记录第一个邻接粒子的位置
-            querySize = 0; // 重置查询大小
-            query(id0, maxDist); // 查询粒子邻域
-
-            for(int j = 0; j < querySize; j++){ // 遍历所有备选碰撞粒子
-                int id1 = queryParticles[j]->index;      // 获取备选粒子的索引
-                if(id1 >= id0) continue;                 // 确保 id1 < id0，避免重复计算
-                float dist2 = glm::length(particleMap[id0]->Position - queryParticles[j]->Position); // 计算粒子间距离的平方
-                dist2 *= dist2; // 计算距离的平方
-
-                if(dist2 > maxDist2) continue; // 如果距离大于 maxDist，则跳过
-
-                if(num >= adjIds.size()){
-                    adjIds.resize(num * 2); // 确保 adjIds 有足够的空间
-                }
 
-                adjIds[num++] = id1; // 将邻接粒子索引存入 adjIds
-            }
+        // 2. 前缀和
+        parallelPrefixSum(firstAdjId.data(), n + 1);
+        int num = firstAdjId[n];
+        if(num > (int)adjIds.size()){
+            adjIds.resize(num * 2); // 确保 adjIds 有足够的空间
         }
 
-
-        firstAdjId[particleMap.size()] = num; // 记录最后一个邻接粒子的位置
+        // 3. 写入邻接粒子下标
+        #pragma omp parallel for schedule(dynamic, 256) if(n > 1024)
+        for(int id0 = 0; id0 < n; id0++){
+            int write = firstAdjId[id0];
+            query(positions, id0, maxDist, [&](int id1) {
+                if(id1 == id0) return;
+                glm::vec3 diff = positions[id0] - positions[id1];
+                if(glm::dot(diff, diff) > maxDist2) return;
+                adjIds[write++] = id1; // 将邻接粒子索引存入 adjIds
+            });
+        }
     }
 
-    void query(int id, float maxDist){
-        if(id < 0 || id >= (int)particleMap.size()) return;
-        
-        //Vertex_H *p = particleMap[id];
-        Vertex_H *p = (*allParticles)[id];
-
-        if(!p) return;
+    // 对粒子 id 周围 maxDist 范围内所有 cell 中的粒子调用 visit(粒子下标)
+    template <typename Visitor>
+    void query(const std::vector<glm::vec3>& positions, int id, float maxDist, Visitor visit){
+        glm::vec3 pos = positions[id];
+        int x0 = cellCoord(pos.x - maxDist);         // 坐标最小的格子
+        int y0 = cellCoord(pos.y - maxDist);
+        int z0 = cellCoord(pos.z - maxDist);
 
-        querySize = 0; // 重置查询大小
+        int x1 = cellCoord(pos.x + maxDist);         // 坐标最大的格子
+        int y1 = cellCoord(pos.y + maxDist);
+        int z1 = cellCoord(pos.z + maxDist);
 
-        glm::vec3 pos = p->Position;
-        int x0 = static_cast<int>(pos.x - maxDist);         // 坐标最小的格子
-        int y0 = static_cast<int>(pos.y - maxDist);
-        int z0 = static_cast<int>(pos.z - maxDist);
-
-        int x1 = static_cast<int>(pos.x + maxDist);         // 坐标最大的格子
-        int y1 = static_cast<int>(pos.y + maxDist);
-        int z1 = static_cast<int>(pos.z + maxDist);
+        // 不同的 cell 可能哈希到同一个桶，桶只访问一次，避免重复的邻接粒子
+        std::vector<int>& visited = visitedBuckets[omp_get_thread_num()];
+        visited.clear();
 
         for(int xi = x0; xi <= x1; xi++){
             for(int yi = y0; yi <= y1; yi++){
                 for(int zi = z0; zi <= z1; zi++){
-                    int64_t h = hashPos(glm::vec3(xi, yi, zi));
+                    int h = hashCoords(xi, yi, zi);
 
-                    if(h < 0 || h + 1 >= cellCount.size()){
-                        printf("Hash index out of bounds: %lld\n", h);
-                        continue; // 跳过无效的哈希索引
-                    }
+                    if(std::find(visited.begin(), visited.end(), h) != visited.end()) continue;
+                    visited.push_back(h);
 
-                    int start = cellCount[h].count;
-                    int end = cellCount[h + 1].count;
+                    int start = cellStart[h];
+                    int end = cellStart[h + 1];
 
-                    for(unsigned int i = start; i < end; i++){
-                        queryParticles[querySize++] = particleMap[i];  // queryParticles 备选碰撞粒子指针
+                    for(int i = start; i < end; i++){
+                        visit(cellEntries[i]);  // 备选碰撞粒子下标
                     }
                 }
             }
@@ -314,4 +220,4 @@ public:
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,201 @@
+#pragma once
+#ifndef JACOBI_SOLVER_H
+#define JACOBI_SOLVER_H
+
+#include <glm/glm.hpp>
+#include "DistanceConstraint.h"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <omp.h>
+
+/*
+    Jacobi 方式的距离约束求解（不需要着色）
+    一次迭代分两遍，每遍内部完全并行、没有写冲突：
+    1. 每条约束根据当前位置算出 dLambda，累加到 lambda，修正量 g = dLambda / len * (p0 - p1) 写到自己的槽里；
+    2. 每个粒子按关联表 (CSR) 收集所有相关约束的修正量，乘自己的逆质量后加到位置上。
+    简单 Jacobi 会在同一个粒子上把多条约束的修正量叠加，过冲后发散（旧的 substep() 就是这样）。
+    这里用 mass splitting：粒子的质量平均分给它的 n 条约束，每条约束看到的逆质量是 n * w，
+    dLambda = (-C - alpha * lambda) / (n0 * w0 + n1 * w1 + alpha)。粒子的位移正好是 M^-1 * sum(grad(C)^T * dLambda)，
+    和累加的 lambda 一致，所以收敛后的软硬和 Gauss-Seidel 相同，也不随顶点的度数变化。
+    mass splitting 收敛慢，再加 Chebyshev 半迭代加速，位置和 lambda 用同一个 omega 外推，保持两者一致：
+    x(k+1) = omega(k+1) * (x^(k+1) - x(k-1)) + x(k-1)，omega 按谱半径 spectralRadius 递推。
+*/
+class JacobiSolver {
+public:
+    float relaxation = 1.0f;       // 松弛系数，dLambda 乘以它
+    bool chebyshev = true;         // 是否使用 Chebyshev 加速
+    float spectralRadius = 0.9f;   // Jacobi 迭代矩阵谱半径的估计，越接近 1 加速越激进
+    int chebyshevDelay = 1;        // 前几次迭代不加速（omega = 1），之后开始递推。第一次迭代还没有 x(k-1)，至少为 1，
+                                   // 所以每个子步只迭代 chebyshevDelay 次或更少（Simulator::iterCount 默认为 1）时不会加速
+
+    // 根据两张约束表建立粒子 -> 约束的关联表。约束表或粒子编号变化后需要重新调用
+    void build(int particleCount, const std::vector<DistanceConstraint>& stretch, const std::vector<DistanceConstraint>& bending) {
+        int numStretch = (int)stretch.size();
+        int numConstraints = numStretch + (int)bending.size();
+        auto constraintAt = [&](int id) -> const DistanceConstraint& {
+            return id < numStretch ? stretch[id] : bending[id - numStretch];
+        };
+
+        // 关联表条目：约束编号 * 2 + 端点（0 为 i0，1 为 i1）
+        firstIncident.assign(particleCount + 1, 0);
+        for (int id = 0; id < numConstraints; id++) {
+            const DistanceConstraint& c = constraintAt(id);
+            firstIncident[c.i0 + 1]++;
+            firstIncident[c.i1 + 1]++;
+        }
+        for (int i = 0; i < particleCount; i++) firstIncident[i + 1] += firstIncident[i];
+
+        incident.resize(firstIncident[particleCount]);
+        std::vector<int> fill(firstIncident.begin(), firstIncident.end() - 1);
+        for (int id = 0; id < numConstraints; id++) {
+            const DistanceConstraint& c = constraintAt(id);
+            incident[fill[c.i0]++] = id * 2;
+            incident[fill[c.i1]++] = id * 2 + 1;
+        }
+
+        splitCount.resize(particleCount);
+        for (int i = 0; i < particleCount; i++) splitCount[i] = float(std::max(1, firstIncident[i + 1] - firstIncident[i]));
+
+        correction.assign(numConstraints, glm::vec3(0.0f));
+        previous.resize(particleCount);
+        previousLambda.resize(numConstraints);
+    }
+
+    // 粒子重排后更新关联表，不用重新统计：newToOld 为粒子的新旧编号，
+    // stretchOldToNew / bendingOldToNew 为两张约束表里约束的新位置（约束的端点先后不变）
+    void remap(const std::vector<int>& newToOld, const std::vector<int>& stretchOldToNew, const std::vector<int>& bendingOldToNew) {
+        int particleCount = (int)newToOld.size();
+        int numStretch = (int)stretchOldToNew.size();
+        std::vector<int> oldFirst;
+        std::vector<int> oldIncident;
+        oldFirst.swap(firstIncident);
+        oldIncident.swap(incident);
+
+        firstIncident.resize(particleCount + 1);
+        incident.resize(oldIncident.size());
+        firstIncident[0] = 0;
+        for (int i = 0; i < particleCount; i++) {
+            int old = newToOld[i];
+            int fill = firstIncident[i];
+            for (int j = oldFirst[old]; j < oldFirst[old + 1]; j++) {
+                int id = oldIncident[j] >> 1;
+                int newId = id < numStretch ? stretchOldToNew[id] : numStretch + bendingOldToNew[id - numStretch];
+                incident[fill++] = newId * 2 + (oldIncident[j] & 1);
+            }
+            firstIncident[i + 1] = fill;
+        }
+
+        std::vector<float> oldCount;
+        oldCount.swap(splitCount);
+        splitCount.resize(particleCount);
+        for (int i = 0; i < particleCount; i++) splitCount[i] = oldCount[newToOld[i]];
+    }
+
+    // 每个子步开始时调用（lambda 已经清零），重新开始 Chebyshev 递推
+    void beginSubStep(const std::vector<glm::vec3>& positions) {
+        iteration = 0;
+        omega = 1.0f;
+        if (chebyshev) {
+            previous = positions;
+            std::fill(previousLambda.begin(), previousLambda.end(), 0.0f);
+        }
+    }
+
+    // 一次 Jacobi 迭代，返回边长约束修正前的相对误差
+    ConstraintResidual iterate(std::vector<glm::vec3>& pos, const std::vector<float>& invMass,
+                  const std::vector<DistanceConstraint>& stretch, std::vector<float>& stretchLambda,
+                  const std::vector<DistanceConstraint>& bending, std::vector<float>& bendingLambda,
+                  float invDt2) {
+        int numStretch = (int)stretch.size();
+        int numBending = (int)bending.size();
+        int n = (int)pos.size();
+
+        bool accelerate = chebyshev && iteration >= chebyshevDelay;
+        if (chebyshev) {
+            if (iteration == chebyshevDelay) omega = 2.0f / (2.0f - spectralRadius * spectralRadius);
+            else if (iteration > chebyshevDelay) omega = 4.0f / (4.0f - spectralRadius * spectralRadius * omega);
+        }
+        float w = omega;
+
+        // 1. 约束：各自算修正量，lambda 和位置一起外推
+        float maxError = 0.0f;
+        double sumSquared = 0.0;
+        #pragma omp parallel for schedule(static) reduction(max:maxError) reduction(+:sumSquared) if(numStretch > 4096)
+        for (int k = 0; k < numStretch; k++) {
+            float before = stretchLambda[k];
+            float error = computeCorrection(pos, invMass, stretch[k], stretchLambda[k], invDt2, correction[k]);
+            maxError = std::max(maxError, error);
+            sumSquared += double(error) * error;
+            if (chebyshev) extrapolateLambda(stretchLambda[k], previousLambda[k], before, accelerate, w);
+        }
+        #pragma omp parallel for schedule(static) if(numBending > 4096)
+        for (int k = 0; k < numBending; k++) {
+            float before = bendingLambda[k];
+            computeCorrection(pos, invMass, bending[k], bendingLambda[k], invDt2, correction[numStretch + k]);
+            if (chebyshev) extrapolateLambda(bendingLambda[k], previousLambda[numStretch + k], before, accelerate, w);
+        }
+
+        // 2. 粒子：收集修正量，再做 Chebyshev 外推
+        #pragma omp parallel for schedule(static) if(n > 4096)
+        for (int i = 0; i < n; i++) {
+            int first = firstIncident[i];
+            int last = firstIncident[i + 1];
+            if (invMass[i] == 0.0f || first == last) continue;
+
+            glm::vec3 sum(0.0f);
+            for (int j = first; j < last; j++) {
+                int entry = incident[j];
+                const glm::vec3& g = correction[entry >> 1];
+                if (entry & 1) sum -= g;
+                else sum += g;
+            }
+            glm::vec3 current = pos[i];
+            glm::vec3 next = current + sum * invMass[i];
+            if (accelerate) next = w * (next - previous[i]) + previous[i];
+            if (chebyshev) previous[i] = current;
+            pos[i] = next;
+        }
+        iteration++;
+        ConstraintResidual residual;
+        residual.maxError = maxError;
+        residual.sumSquared = sumSquared;
+        return residual;
+    }
+
+private:
+    std::vector<int> firstIncident;   // 粒子 i 的关联约束为 incident[firstIncident[i], firstIncident[i + 1])
+    std::vector<int> incident;
+    std::vector<glm::vec3> correction; // 每条约束本次迭代的修正量（先边长约束，后弯曲约束）
+    std::vector<glm::vec3> previous;   // 上一次迭代的位置 x(k-1)
+    std::vector<float> previousLambda; // 上一次迭代的 lambda(k-1)，和 correction 同序
+    std::vector<float> splitCount;     // 每个粒子关联的约束数，mass splitting 用
+    int iteration = 0;
+    float omega = 1.0f;
+
+    // lambda(k+1) = omega * (lambda^(k+1) - lambda(k-1)) + lambda(k-1)，和粒子位置的外推相同；before 为 lambda(k)
+    static void extrapolateLambda(float& lambda, float& previousLambda, float before, bool accelerate, float omega) {
+        if (accelerate) lambda = omega * (lambda - previousLambda) + previousLambda;
+        previousLambda = before;
+    }
+
+    // XPBD 修正量（mass splitting）：p0 加 w0 * g，p1 减 w1 * g；返回修正前的相对误差
+    float computeCorrection(const std::vector<glm::vec3>& pos, const std::vector<float>& invMass,
+                            const DistanceConstraint& c, float& lambda, float invDt2, glm::vec3& g) const {
+        g = glm::vec3(0.0f);
+        float w = splitCount[c.i0] * invMass[c.i0] + splitCount[c.i1] * invMass[c.i1];
+        if (w == 0.0f) return 0.0f;
+        glm::vec3 d = pos[c.i0] - pos[c.i1];
+        float len = glm::length(d);
+        if (len < 1e-6f) return 0.0f;
+
+        float alpha = c.compliance * invDt2;
+        float dLambda = relaxation * (c.restLength - len - alpha * lambda) / (w + alpha);
+        lambda += dLambda;
+        g = d * (dLambda / len);
+        return c.restLength > 0.0f ? std::abs(len - c.restLength) / c.restLength : 0.0f;
+    }
+};
+
+#endif
@@ -66,22 +66,30 @@ class Mesh {
         vector<Vertex_H> vertices;
         vector<unsigned int> indices;
         vector<Texture_H> textures;
-        unsigned int VAO;
-        unsigned int VBO, EBO;
+        unsigned int VAO = 0;
+        unsigned int VBO = 0, EBO = 0;
+        unsigned int dynamicVBO = 0; // 位置 + 法线，每帧更新；VBO 里的其余属性只上传一次
+        int particleOffset = -1;     // 第一个顶点在 allParticles 中的下标（gatherParticles 设置），-1 表示不参与模拟
 
         std::vector<EdgeIndex> tempEdgeList;
         std::vector<Triangle> triangles; // 三角形索引
 
         /* functions */
-        Mesh(vector<Vertex_H> vertices, vector<unsigned int> indices, vector<Texture_H> textures, std::vector<EdgeIndex> tempEdgeList, std::vector<Triangle> triangles) {
-            this->vertices = vertices;
-            this->indices = indices;
-            this->textures = textures;
-            this->tempEdgeList = tempEdgeList;
-            this->triangles = triangles;
-            setupMesh();
+        // 参数按值传入再移动到成员里，调用方传右值时整个过程没有拷贝
+        Mesh(vector<Vertex_H> vertices, vector<unsigned int> indices, vector<Texture_H> textures, std::vector<EdgeIndex> tempEdgeList, std::vector<Triangle> triangles)
+            : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)),
+              tempEdgeList(std::move(tempEdgeList)), triangles(std::move(triangles)) {
+#ifndef CLOTHSIM_HEADLESS
+            setupMesh(); // headless 模式下没有 OpenGL 上下文
+#endif
         }
 
+        // 模拟用的 Edge / Vertex_H* 指向 vertices 的元素，只允许移动（移动不会改变元素地址）
+        Mesh(const Mesh&) = delete;
+        Mesh& operator=(const Mesh&) = delete;
+        Mesh(Mesh&&) = default;
+        Mesh& operator=(Mesh&&) = default;
+
         void Draw(Shader shader){
             unsigned int diffuseNr = 1;
             unsigned int specularNr = 1;
@@ -125,6 +133,10 @@ class Mesh {
                 glDeleteBuffers(1, &VBO);
                 VBO = 0;
             }
+            if(dynamicVBO != 0){
+                glDeleteBuffers(1, &dynamicVBO);
+                dynamicVBO = 0;
+            }
             if(EBO != 0){
                 glDeleteBuffers(1, &EBO);
                 EBO = 0;
@@ -135,20 +147,65 @@ class Mesh {
             return &vertices;
         }
 
-        void updateVertexPositions() {
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex_H), &vertices[0]);
+        // 用模拟线程发布的位置快照更新动态 VBO，快照按 allParticles 的顺序存放，本网格的顶点从 particleOffset 开始
+        // 法线按面积加权的面法线重新计算。只上传 24 字节 / 顶点，而不是整个 Vertex_H
+        void updateDynamicVertices(const std::vector<glm::vec3>& particlePositions) {
+            size_t n = vertices.size();
+            bool simulated = particleOffset >= 0 && particleOffset + n <= particlePositions.size();
+            dynamicData.resize(2 * n);
+            for (size_t i = 0; i < n; i++) {
+                dynamicData[2 * i] = simulated ? particlePositions[particleOffset + i] : vertices[i].Position;
+                dynamicData[2 * i + 1] = glm::vec3(0.0f);
+            }
+            for (size_t f = 0; f + 2 < indices.size(); f += 3) {
+                unsigned int i0 = indices[f], i1 = indices[f + 1], i2 = indices[f + 2];
+                glm::vec3 p0 = dynamicData[2 * i0];
+                glm::vec3 faceNormal = glm::cross(dynamicData[2 * i1] - p0, dynamicData[2 * i2] - p0); // 长度为面积的两倍
+                dynamicData[2 * i0 + 1] += faceNormal;
+                dynamicData[2 * i1 + 1] += faceNormal;
+                dynamicData[2 * i2 + 1] += faceNormal;
+            }
+            for (size_t i = 0; i < n; i++) {
+                glm::vec3& normal = dynamicData[2 * i + 1];
+                float len = glm::length(normal);
+                normal = len > 1e-12f ? normal / len : vertices[i].Normal;
+            }
+
+            // orphan：重新分配存储，驱动不用等 GPU 用完上一帧的数据
+            GLsizeiptr size = (GLsizeiptr)(dynamicData.size() * sizeof(glm::vec3));
+            glBindBuffer(GL_ARRAY_BUFFER, dynamicVBO);
+            glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, size, dynamicData.data());
         }
 
     private:
+        std::vector<glm::vec3> dynamicData; // 上传用的缓冲：位置、法线交替存放
+
         /* rendering data */
         void setupMesh(){
             glGenVertexArrays(1, &VAO);
             glGenBuffers(1, &VBO);
             glGenBuffers(1, &EBO);
+            glGenBuffers(1, &dynamicVBO);
             
             glBindVertexArray(VAO);
 
+            // 位置和法线放在单独的动态 VBO 里（每个顶点 24 字节），模拟时只更新它
+            dynamicData.resize(2 * vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++) {
+                dynamicData[2 * i] = vertices[i].Position;
+                dynamicData[2 * i + 1] = vertices[i].Normal;
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, dynamicVBO);
+            glBufferData(GL_ARRAY_BUFFER, dynamicData.size() * sizeof(glm::vec3), dynamicData.data(), GL_STREAM_DRAW);
+
+            glEnableVertexAttribArray(0);	
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (void*)0);
+            // vertex normals
+            glEnableVertexAttribArray(1);	
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (void*)sizeof(glm::vec3));
+
+            // 其余属性不会变，留在静态 VBO 里
             glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
             glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex_H), &vertices[0], GL_STATIC_DRAW);
@@ -156,13 +213,8 @@ class Mesh {
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
-            glEnableVertexAttribArray(0);	
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex_H), (void*)0);
-            // vertex normals
-            glEnableVertexAttribArray(1);	
                                                                                 // offsetof(struct，var)
                                                                                 // Returns the distance between the variable and the first byte in the Vertex structure, in bytes
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex_H), (void*)offsetof(Vertex_H, Normal));
             // vertex texture coords
             glEnableVertexAttribArray(2);	
             glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex_H), (void*)offsetof(Vertex_H, TexCoords));
@@ -183,4 +235,4 @@ class Mesh {
         }
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -18,6 +18,7 @@
 #include "Particle.h"
 #include "Mesh.h"
 #include "Shader_s.h"
+#include "Profiler.h"
 
 #include <vector>
 #include <string>
@@ -26,6 +27,11 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 #include <random>
 
@@ -41,6 +47,17 @@ struct Edge{
     int triangleIndex2; // for simulation, index
 };
 
+// 顶点位置的哈希（按 float 的位模式，和 bendEdges3 里的 == 比较一致）
+struct PositionHash {
+    size_t operator()(const glm::vec3& p) const {
+        uint32_t x, y, z;
+        std::memcpy(&x, &p.x, 4);
+        std::memcpy(&y, &p.y, 4);
+        std::memcpy(&z, &p.z, 4);
+        return (size_t(x) * 73856093u) ^ (size_t(y) * 19349663u) ^ (size_t(z) * 83492791u);
+    }
+};
+
 
 
 class Model {
@@ -52,8 +69,8 @@ public:
     bool gammaCorrection;
 
     // 模拟用
-    std::vector<EdgeIndex> edgeIndices; // 边索引
-    std::vector<Triangle> triangles; // 三角形索引
+    std::vector<Triangle> triangles; // 三角形索引（只有旧的 bendEdges2 使用，每个 Mesh 的三角形在 Mesh::triangles 里）
+    int duplicateEdgesRemoved = 0; // 相邻三角形共享的边去重的数量
 
     std::vector<Edge> edgeList;
     std::vector<Edge> bendingEdges; // 绑定边
@@ -73,19 +90,57 @@ public:
 
 
     Model(string const& path, int vertexCount,bool gamma = false) : gammaCorrection(gamma) {
+        ProfileScope scope(ProfilePhase::ModelLoad);
         //stbi_set_flip_vertically_on_load(true);
         this->vertexLoaded = vertexCount;
+        auto loadStart = std::chrono::high_resolution_clock::now();
         loadModel(path);
         this->name = path;
+        auto bendStart = std::chrono::high_resolution_clock::now();
         //bendEdges(); // 5400
         //bendEdges2(); // 5400
-        bendEdges3(); //40266
+        //bendEdges3(); //40266 O(E^2)
+        buildBendingEdges();
+        auto loadEnd = std::chrono::high_resolution_clock::now();
         std::cout << "bending edges: " << bendingEdges.size() << std::endl;
+        printf("load time: %.2f ms (assimp + edges %.2f ms, bending edges %.2f ms)\n",
+               std::chrono::duration<double, std::milli>(loadEnd - loadStart).count(),
+               std::chrono::duration<double, std::milli>(bendStart - loadStart).count(),
+               std::chrono::duration<double, std::milli>(loadEnd - bendStart).count());
         std::cout << "edge list size: " << edgeList.size() << std::endl;
+        printf("stretch constraints: %zu unique edges (%d shared-edge duplicates removed)\n", edgeList.size(), duplicateEdgesRemoved);
         //bendingToEdges();
         // std::cout << "bending edges: " << bendingEdges.size() << std::endl;
         // std::cout << "edge list size: " << edgeList.size() << std::endl;
     }
+
+    // 程序生成的网格（例如 benchmark 用的方形布料），不经过 assimp
+    // indices 每三个为一个三角形
+    Model(string const& name, vector<Vertex_H> vertices, vector<unsigned int> indices, int vertexCount = 0) : gammaCorrection(false) {
+        this->vertexLoaded = vertexCount;
+        this->name = name;
+        vector<EdgeIndex> edgeIndices;
+        vector<Triangle> triangles;
+        for (size_t f = 0; f + 2 < indices.size(); f += 3) {
+            addTriangle(vertices, (int)(f / 3), indices[f], indices[f + 1], indices[f + 2], edgeIndices, triangles);
+        }
+        duplicateEdgesRemoved += removeDuplicateEdges(edgeIndices);
+        meshes.emplace_back(std::move(vertices), std::move(indices), vector<Texture_H>(), std::move(edgeIndices), std::move(triangles));
+        collectEdges();
+        buildBendingEdges();
+        std::cout << "bending edges: " << bendingEdges.size() << std::endl;
+        std::cout << "edge list size: " << edgeList.size() << std::endl;
+        printf("stretch constraints: %zu unique edges (%d shared-edge duplicates removed)\n", edgeList.size(), duplicateEdgesRemoved);
+    }
+
+    // Edge、triangleVertices 和 Simulator 里保存的都是指向 Mesh::vertices 元素的指针。
+    // 拷贝 Model 会得到指向旧对象的指针，所以禁止拷贝；移动只转移 vector 的缓冲区，指针仍然有效，
+    // std::vector<Model> 扩容时也是移动
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model(Model&&) = default;
+    Model& operator=(Model&&) = default;
+
     void Draw(Shader& shader) {
         for (unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
@@ -183,8 +238,13 @@ private:
         directory = path.substr(0, path.find_last_of('/'));
 
         // DFS Recursively traverse all nodes. The nodes of the model exist in a tree structure (such as a car model)
+        meshes.reserve(scene->mNumMeshes);
         processNode(scene->mRootNode, scene);
-    
+        collectEdges();
+    }
+
+    // 把每个 Mesh 的边索引和三角形转换成指向顶点的 Edge 和 triangleVertices
+    void collectEdges() {
         for (Mesh& mesh : meshes) {
             for (auto& e : mesh.tempEdgeList) {
                 Vertex_H* v0 = &mesh.vertices[e.i0];
@@ -221,7 +281,7 @@ private:
         for (unsigned int i = 0; i < node->mNumMeshes; i++) {
             // save mesh data
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            meshes.push_back(processMesh(mesh, scene)); // 移动，不拷贝顶点
         }
 
         // Children nodes
@@ -241,6 +301,8 @@ private:
         vector<Vertex_H> vertices;
         vector<unsigned int> indices;
         vector<Texture_H> textures;
+        vector<EdgeIndex> edgeIndices; // 只属于这个 Mesh 的边
+        vector<Triangle> triangles;    // 只属于这个 Mesh 的三角形
 
         for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
             Vertex_H vertex;
@@ -322,23 +384,7 @@ private:
             int i2 = face.mIndices[2];
 
             // 添加边 （边为两个指针 + 边的长度）
-            float l1 = glm::length(vertices[i0].Position - vertices[i1].Position);
-            float l2 = glm::length(vertices[i1].Position - vertices[i2].Position);
-            float l3 = glm::length(vertices[i2].Position - vertices[i0].Position);
-
-            //std::cout << l1 << ", " << l2 << ", " << l3 << std::endl;
-            // a粒子 b粒子 ab长度 i三角图元下标
-            // edgeList.push_back({ &vertices[i0], &vertices[i1], l1, i});
-            // edgeList.push_back({ &vertices[i1], &vertices[i2], l2, i});
-            // edgeList.push_back({ &vertices[i2], &vertices[i0], l3, i});
-
-            edgeIndices.push_back({ i0, i1, i, l1 });
-            edgeIndices.push_back({ i1, i2, i, l2 });
-            edgeIndices.push_back({ i2, i0, i, l3 });
-
-            // i 三角图元下标 对应的三个顶点
-            //triangleVertices[i] = { &vertices[i0], &vertices[i1], &vertices[i2] };
-            triangles.push_back({ i ,i0, i1, i2 });
+            addTriangle(vertices, i, i0, i1, i2, edgeIndices, triangles);
             // triangleVertices[i].push_back(&vertices[i0]);
             // triangleVertices[i].push_back(&vertices[i1]);
             // triangleVertices[i].push_back(&vertices[i2]);
@@ -378,8 +424,49 @@ private:
         std::vector<Texture_H> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
+        // 相邻三角形共享的边只保留一条约束
+        duplicateEdgesRemoved += removeDuplicateEdges(edgeIndices);
+
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures, edgeIndices, triangles);
+        return Mesh(std::move(vertices), std::move(indices), std::move(textures), std::move(edgeIndices), std::move(triangles));
+    }
+
+    // 三角形 i 的三条边和顶点索引，供模拟使用
+    void addTriangle(const vector<Vertex_H>& vertices, int i, int i0, int i1, int i2,
+                     vector<EdgeIndex>& edgeIndices, vector<Triangle>& triangles) {
+        float l1 = glm::length(vertices[i0].Position - vertices[i1].Position);
+        float l2 = glm::length(vertices[i1].Position - vertices[i2].Position);
+        float l3 = glm::length(vertices[i2].Position - vertices[i0].Position);
+
+        //std::cout << l1 << ", " << l2 << ", " << l3 << std::endl;
+        // a粒子 b粒子 ab长度 i三角图元下标
+        // edgeList.push_back({ &vertices[i0], &vertices[i1], l1, i});
+        // edgeList.push_back({ &vertices[i1], &vertices[i2], l2, i});
+        // edgeList.push_back({ &vertices[i2], &vertices[i0], l3, i});
+
+        edgeIndices.push_back({ i0, i1, i, l1 });
+        edgeIndices.push_back({ i1, i2, i, l2 });
+        edgeIndices.push_back({ i2, i0, i, l3 });
+
+        // i 三角图元下标 对应的三个顶点
+        //triangleVertices[i] = { &vertices[i0], &vertices[i1], &vertices[i2] };
+        triangles.push_back({ i ,i0, i1, i2 });
+    }
+
+    // 每条边只保留第一次出现的那一条（不区分方向），保持原来的顺序，返回去掉的数量
+    static int removeDuplicateEdges(vector<EdgeIndex>& edgeIndices) {
+        std::unordered_set<uint64_t> seen;
+        seen.reserve(edgeIndices.size());
+        size_t write = 0;
+        for (size_t k = 0; k < edgeIndices.size(); k++) {
+            uint32_t a = (uint32_t)std::min(edgeIndices[k].i0, edgeIndices[k].i1);
+            uint32_t b = (uint32_t)std::max(edgeIndices[k].i0, edgeIndices[k].i1);
+            if (!seen.insert((uint64_t(a) << 32) | b).second) continue;
+            edgeIndices[write++] = edgeIndices[k];
+        }
+        int removed = (int)(edgeIndices.size() - write);
+        edgeIndices.resize(write);
+        return removed;
     }
     
     vector<Texture_H> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName) {
@@ -620,6 +707,61 @@ private:
         }
     }
 
+    /*
+        绑定边（线性时间）：
+        1. 按位置给顶点编号，位置相同的顶点视为同一个点（与 bendEdges3 按位置比较一致）
+        2. 遍历所有三角形的三条边，以两个端点编号作为 key，记录第一个三角形的对顶点
+        3. 第二个三角形遇到同一条边时，两个对顶点连成一条 bending 边
+        bendEdges3 会把每条边和自己也比较一次、并且每对三角形算两遍，这里每条内部边只生成一条。
+    */
+    void buildBendingEdges() {
+        struct EdgeSide {
+            Vertex_H* opposite; // 对顶点
+            int triangleIndex;
+        };
+        std::unordered_map<glm::vec3, int, PositionHash> positionId; // 位置 -> 顶点编号
+        std::unordered_map<uint64_t, EdgeSide> edgeSide;              // 边 -> 第一个相邻三角形
+        positionId.reserve(allParticles.size());
+
+        auto idOf = [&](const Vertex_H* v) {
+            auto it = positionId.emplace(v->Position, (int)positionId.size()).first;
+            return (uint64_t)it->second;
+        };
+
+        for (Mesh& mesh : meshes) {
+            edgeSide.reserve(edgeSide.size() + mesh.indices.size());
+            for (size_t f = 0; f + 2 < mesh.indices.size(); f += 3) {
+                Vertex_H* v[3] = { &mesh.vertices[mesh.indices[f]], &mesh.vertices[mesh.indices[f + 1]], &mesh.vertices[mesh.indices[f + 2]] };
+                uint64_t id[3] = { idOf(v[0]), idOf(v[1]), idOf(v[2]) };
+                int triangleIndex = (int)(f / 3);
+
+                for (int k = 0; k < 3; k++) {
+                    uint64_t a = id[k];
+                    uint64_t b = id[(k + 1) % 3];
+                    if (a == b) continue; // 退化三角形
+                    uint64_t key = a < b ? (a << 32) | b : (b << 32) | a;
+                    Vertex_H* opposite = v[(k + 2) % 3];
+
+                    auto it = edgeSide.find(key);
+                    if (it == edgeSide.end()) {
+                        edgeSide.emplace(key, EdgeSide{ opposite, triangleIndex });
+                        continue;
+                    }
+                    // 这条边的第二个三角形：两个对顶点之间加 bending 边
+                    Vertex_H* other = it->second.opposite;
+                    if (other == opposite || other->Position == opposite->Position) continue;
+                    Edge bendingEdge;
+                    bendingEdge.v0 = other;
+                    bendingEdge.v1 = opposite;
+                    bendingEdge.lenght = glm::length(other->Position - opposite->Position);
+                    bendingEdge.triangleIndex = it->second.triangleIndex;
+                    bendingEdge.triangleIndex2 = triangleIndex;
+                    bendingEdges.push_back(bendingEdge);
+                }
+            }
+        }
+    }
+
     // 绑定边到边列表
     // 并清空绑定边和边到三角形的映射
     void bendingToEdges(){
@@ -656,6 +798,12 @@ private:
 };
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma) {
+#ifdef CLOTHSIM_HEADLESS
+    (void)path;
+    (void)directory;
+    (void)gamma;
+    return 0; // headless 模式下不加载纹理
+#else
     string filename = string(path);
     filename = directory + '/' + filename;
 
@@ -690,6 +838,7 @@ unsigned int TextureFromFile(const char* path, const string& directory, bool gam
     }
 
     return textureID;
+#endif
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef PARTICLE_ORDER_H
+#define PARTICLE_ORDER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+/*
+    粒子空间重排 (Morton / Z 序)
+    Assimp 输出的顶点顺序和空间位置无关，相邻的约束和碰撞邻居在数组里可能相隔很远。
+    把包围盒分成 1024^3 的格子，按格子坐标的 Morton 码排序，空间上相近的粒子在数组里也相近。
+    返回 newToOld：新的第 i 个粒子是原来的第 newToOld[i] 个。
+*/
+
+// 把 10 位整数的每一位之间插入两个 0
+inline uint32_t mortonSpread3(uint32_t v) {
+    v &= 0x3ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8)) & 0x0300f00f;
+    v = (v | (v << 4)) & 0x030c30c3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+inline uint32_t mortonCode3(uint32_t x, uint32_t y, uint32_t z) {
+    return mortonSpread3(x) | (mortonSpread3(y) << 1) | (mortonSpread3(z) << 2);
+}
+
+inline std::vector<int> mortonOrder(const std::vector<glm::vec3>& positions) {
+    int n = (int)positions.size();
+    std::vector<int> newToOld(n);
+    if (n == 0) return newToOld;
+
+    glm::vec3 lo = positions[0], hi = positions[0];
+    for (const glm::vec3& p : positions) {
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    glm::vec3 extent = glm::max(hi - lo, glm::vec3(1e-6f));
+    glm::vec3 scale = glm::vec3(1023.0f) / extent;
+
+    std::vector<std::pair<uint32_t, int>> keys(n);
+    for (int i = 0; i < n; i++) {
+        glm::vec3 q = (positions[i] - lo) * scale;
+        keys[i] = { mortonCode3((uint32_t)q.x, (uint32_t)q.y, (uint32_t)q.z), i };
+    }
+    std::sort(keys.begin(), keys.end()); // 同一个格子里保持原来的顺序
+
+    for (int i = 0; i < n; i++) newToOld[i] = keys[i].second;
+    return newToOld;
+}
+
+#endif
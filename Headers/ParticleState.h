@@ -0,0 +1,96 @@
+#pragma once
+#ifndef PARTICLE_STATE_H
+#define PARTICLE_STATE_H
+
+#include <glm/glm.hpp>
+#include "Mesh.h"
+
+#include <vector>
+#include <unordered_set>
+
+/*
+    求解器用的粒子状态 (Structure of Arrays)
+    Vertex_H 里混着 Tangent / Bitangent / 骨骼数据等只有渲染才用的字段，
+    模拟时逐个指针访问会不停地 cache miss。这里把模拟需要的数据按数组连续存放，
+    Simulator 只在这些数组上计算，Mesh::vertices 只在渲染前同步一次。
+*/
+class ParticleState {
+public:
+    std::vector<glm::vec3> position;     // 当前位置
+    std::vector<glm::vec3> oldPosition;  // 上一子步的位置
+    std::vector<glm::vec3> velocity;     // 速度
+    std::vector<float> invMass;          // 逆质量，静态粒子或 mass <= 0 时为 0
+    std::vector<float> radius;           // 粒子半径（地面碰撞用）
+    std::vector<glm::vec3> initPosition; // 初始位置（自碰撞时计算静止距离）
+
+    std::vector<Vertex_H*> vertices;     // 粒子 i 对应的渲染顶点
+    std::vector<int> sourceIndex;        // 粒子 i 在 build 传入数组中的下标，重排后不变
+
+    size_t size() const { return position.size(); }
+
+    // 从渲染顶点构建粒子状态，并把 Vertex_H::index 设为粒子在数组中的下标
+    // 静态粒子（如衣架）在这里一次性设为逆质量 0，求解器里不再查集合
+    void build(const std::vector<Vertex_H*>& particles, const std::unordered_set<Vertex_H*>& statics) {
+        size_t n = particles.size();
+        position.resize(n);
+        oldPosition.resize(n);
+        velocity.resize(n);
+        invMass.resize(n);
+        radius.resize(n);
+        initPosition.resize(n);
+        sourceIndex.resize(n);
+        vertices = particles;
+
+        for (size_t i = 0; i < n; i++) {
+            Vertex_H* v = particles[i];
+            v->index = (int)i;
+            position[i] = v->Position;
+            oldPosition[i] = v->OldPosition;
+            velocity[i] = v->Velocity;
+            invMass[i] = (v->mass > 0.0f && !statics.count(v)) ? 1.0f / v->mass : 0.0f;
+            radius[i] = v->radius;
+            initPosition[i] = v->initPosition;
+            sourceIndex[i] = (int)i;
+        }
+    }
+
+    // 按 newToOld 重排所有数组：新的第 i 个粒子是原来的第 newToOld[i] 个
+    // vertices 跟着一起重排，它就是粒子到渲染顶点的映射表；Vertex_H::index 同步更新
+    void permute(const std::vector<int>& newToOld) {
+        permuteArray(position, newToOld);
+        permuteArray(oldPosition, newToOld);
+        permuteArray(velocity, newToOld);
+        permuteArray(invMass, newToOld);
+        permuteArray(radius, newToOld);
+        permuteArray(initPosition, newToOld);
+        permuteArray(vertices, newToOld);
+        permuteArray(sourceIndex, newToOld);
+        for (size_t i = 0; i < vertices.size(); i++) vertices[i]->index = (int)i;
+    }
+
+    template <typename T>
+    static void permuteArray(std::vector<T>& data, const std::vector<int>& newToOld) {
+        std::vector<T> sorted(data.size());
+        for (size_t i = 0; i < newToOld.size(); i++) sorted[i] = data[newToOld[i]];
+        data.swap(sorted);
+    }
+
+    // 按 build 时的顺序（即 gatherParticles 的顺序）输出位置，不受重排影响
+    // 模拟线程发布给渲染线程的快照用这个顺序，渲染线程不需要读 Vertex_H::index
+    void copyPositionsInSourceOrder(std::vector<glm::vec3>& out) const {
+        out.resize(position.size());
+        for (size_t i = 0; i < position.size(); i++) out[sourceIndex[i]] = position[i];
+    }
+
+    // 把模拟结果写回 Mesh 的顶点，供渲染和哈希表使用
+    void syncToVertices() {
+        for (size_t i = 0; i < vertices.size(); i++) {
+            Vertex_H* v = vertices[i];
+            v->Position = position[i];
+            v->OldPosition = oldPosition[i];
+            v->Velocity = velocity[i];
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,188 @@
+#pragma once
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+/*
+    热路径计时
+    每个阶段一个累加器（原子变量，模拟线程和渲染线程都可以写），界面每帧调用 sample() 取走一次，
+    存进最近 historySize 帧的环形缓冲，用来显示平均值、最大值和曲线。
+    录制打开时同时记下每一段的起止时间，可以导出成 Chrome trace（chrome://tracing / Perfetto 打开）。
+    关闭时每个计时点只有一次 relaxed 原子读和一个分支，可以一直编译在正式版本里。
+*/
+enum class ProfilePhase {
+    Step,        // 一次 Simulator::simulate
+    Reorder,     // Morton 重排
+    Predict,
+    Ground,
+    Constraints,
+    Factorize,   // 投影动力学的矩阵分解（在 constraints 内）
+    Neighbors,   // 检查位移 + 重建邻接表
+    HashClear,
+    HashInsert,
+    HashPrefix,
+    HashMap,
+    HashQuery,
+    Collisions,
+    Velocity,
+    Sync,
+    ModelLoad,
+    GpuUpload,
+    Count
+};
+
+inline const char* profilePhaseName(ProfilePhase phase) {
+    static const char* names[] = {
+        "step", "reorder", "predict", "ground", "constraints", "factorize", "neighbors",
+        "hash clear", "hash insert", "hash prefix", "hash map", "hash query",
+        "collisions", "velocity", "sync", "model load", "gpu upload"
+    };
+    return names[(int)phase];
+}
+
+// 界面里缩进显示的子阶段
+inline int profilePhaseDepth(ProfilePhase phase) {
+    if (phase == ProfilePhase::Step || phase == ProfilePhase::ModelLoad || phase == ProfilePhase::GpuUpload) return 0;
+    if (phase == ProfilePhase::Factorize || (phase >= ProfilePhase::HashClear && phase <= ProfilePhase::HashQuery)) return 2;
+    return 1;
+}
+
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int PhaseCount = (int)ProfilePhase::Count;
+    static constexpr int historySize = 120;        // 界面显示最近多少帧
+    static constexpr size_t maxTraceEvents = 1 << 20; // 录制上限，防止忘记停止时内存无限增长
+
+    std::atomic<bool> enabled{ false };
+
+    // 记录一段 [begin, end)，关闭时直接返回
+    void record(ProfilePhase phase, Clock::time_point begin, Clock::time_point end) {
+        if (!enabled.load(std::memory_order_relaxed)) return;
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        totalNs[(int)phase].fetch_add(ns, std::memory_order_relaxed);
+        calls[(int)phase].fetch_add(1, std::memory_order_relaxed);
+        if (recording.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(traceMutex);
+            if (traceEvents.size() < maxTraceEvents) traceEvents.push_back({ phase, threadId(), begin, end });
+        }
+    }
+
+    // 界面线程每帧调用一次：把累加器里的时间移到环形缓冲
+    void sample() {
+        for (int p = 0; p < PhaseCount; p++) {
+            long long ns = totalNs[p].exchange(0, std::memory_order_relaxed);
+            int n = calls[p].exchange(0, std::memory_order_relaxed);
+            history[p][cursor] = (float)(ns * 1e-6);
+            callHistory[p][cursor] = n;
+        }
+        cursor = (cursor + 1) % historySize;
+    }
+
+    // 最近 historySize 帧里每帧的平均 / 最大毫秒数，以及平均调用次数
+    float averageMs(ProfilePhase phase) const {
+        float sum = 0.0f;
+        for (float ms : history[(int)phase]) sum += ms;
+        return sum / historySize;
+    }
+    float maxMs(ProfilePhase phase) const {
+        return *std::max_element(history[(int)phase], history[(int)phase] + historySize);
+    }
+    float averageCalls(ProfilePhase phase) const {
+        int sum = 0;
+        for (int n : callHistory[(int)phase]) sum += n;
+        return (float)sum / historySize;
+    }
+    // ImGui::PlotLines 用：数据和起始下标（最旧的一帧）
+    const float* historyData(ProfilePhase phase) const { return history[(int)phase]; }
+    int historyOffset() const { return cursor; }
+
+    // Chrome trace 录制
+    void startRecording() {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        traceEvents.clear();
+        traceStart = Clock::now();
+        recording.store(true);
+    }
+    void stopRecording() { recording.store(false); }
+    bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+    size_t traceEventCount() {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        return traceEvents.size();
+    }
+
+    // 写成 Chrome trace 的 JSON（"X" 完整事件，时间单位微秒）
+    bool writeChromeTrace(const std::string& path) {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        std::ofstream out(path);
+        if (!out) return false;
+        out << "{\"traceEvents\":[\n";
+        for (size_t i = 0; i < traceEvents.size(); i++) {
+            const TraceEvent& e = traceEvents[i];
+            double ts = std::chrono::duration<double, std::micro>(e.begin - traceStart).count();
+            double dur = std::chrono::duration<double, std::micro>(e.end - e.begin).count();
+            out << "{\"name\":\"" << profilePhaseName(e.phase) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+                << ",\"ts\":" << ts << ",\"dur\":" << dur << "}" << (i + 1 < traceEvents.size() ? ",\n" : "\n");
+        }
+        out << "]}\n";
+        return true;
+    }
+
+private:
+    struct TraceEvent {
+        ProfilePhase phase;
+        int thread;
+        Clock::time_point begin, end;
+    };
+
+    std::atomic<long long> totalNs[PhaseCount] = {};
+    std::atomic<int> calls[PhaseCount] = {};
+    float history[PhaseCount][historySize] = {};
+    int callHistory[PhaseCount][historySize] = {};
+    int cursor = 0;
+
+    std::atomic<bool> recording{ false };
+    std::mutex traceMutex;
+    std::vector<TraceEvent> traceEvents;
+    Clock::time_point traceStart = Clock::now();
+
+    // trace 里的线程编号：按第一次记录的顺序编号
+    static int threadId() {
+        static std::atomic<int> nextId{ 0 };
+        thread_local int id = nextId.fetch_add(1);
+        return id;
+    }
+};
+
+// 全局唯一的 profiler
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+// 作用域计时：构造时开始，析构时记录
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePhase phase) : phase(phase), active(profiler().enabled.load(std::memory_order_relaxed)) {
+        if (active) begin = Profiler::Clock::now();
+    }
+    ~ProfileScope() {
+        if (active) profiler().record(phase, begin, Profiler::Clock::now());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfilePhase phase;
+    bool active;
+    Profiler::Clock::time_point begin;
+};
+
+#endif
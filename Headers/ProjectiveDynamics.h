@@ -0,0 +1,188 @@
+#pragma once
+#ifndef PROJECTIVE_DYNAMICS_H
+#define PROJECTIVE_DYNAMICS_H
+
+#include <glm/glm.hpp>
+#include "DistanceConstraint.h"
+#include "SparseCholesky.h"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <omp.h>
+
+/*
+    Projective Dynamics (Bouaziz et al. 2014) 的距离约束求解
+    每个子步最小化 |x - s|^2_M / (2 h^2) + sum_k w_k / 2 |x_i0 - x_i1 - p_k|^2，s 为预测位置，交替两步：
+    1. local：每条约束把当前的边投影到静止长度 p_k = rest * d / |d|，约束之间互不相关，完全并行；
+    2. global：解 (M / h^2 + sum_k w_k A_k^T A_k) x = M / h^2 s + sum_k w_k A_k^T p_k。
+       实际求的是相对预测位置的位移 x - s，右边化成 sum_k w_k A_k^T (p_k - A_k s)，
+       不含 M / h^2 s 这样的大数，单精度的右端项不会在粒子坐标较大时损失精度。
+    左边的矩阵只和质量、刚度、h 以及约束图有关，分解一次之后每次迭代只做前代和回代（x, y, z 共用）。
+    刚度 w = 1 / compliance，和 XPBD 的柔度含义一致（同样的 compliance 收敛后是同样的软硬）。
+    静止粒子作为 Dirichlet 边界不进矩阵，和它相连的约束把它的位置移到右边。
+    矩阵和 h 有关，所以 Projective Dynamics 模式下不用自适应子步（见 Simulator::simulate），
+    h 固定时只在加载或约束表变化后分解一次；h 变了（比如换了帧长）才重新分解。
+    每次迭代要把 envelope 存储的 L 读两遍（前代、回代，单线程），RCM 排序后每行约为 O(sqrt(n)) 个元素，
+    所以每次迭代比 Gauss-Seidel 贵一个数量级，而且随网格变大越来越贵（benchmark 输出每次迭代的 ns / 粒子和 L 的大小）。
+*/
+class ProjectiveDynamicsSolver {
+public:
+    // compliance 低于它的约束（包括 0）按这个柔度处理。刚度比 M / h^2 大太多时 local 步的方向几乎锁死，
+    // 布料转不动、有限次迭代下还会积累能量，1e-6 在常用的子步长下仍然足够硬
+    float minCompliance = 1e-6f;
+
+    // 根据约束表和质量建立编号和关联表，清空已有的分解。约束表或静止粒子变化后需要重新调用，粒子重排只需要 remap
+    void build(const std::vector<float>& invMass, const std::vector<DistanceConstraint>& stretch, const std::vector<DistanceConstraint>& bending) {
+        int n = (int)invMass.size();
+        numStretch = (int)stretch.size();
+        constraints = stretch;
+        constraints.insert(constraints.end(), bending.begin(), bending.end());
+        int numConstraints = (int)constraints.size();
+
+        // 只有可以移动的粒子进矩阵
+        row.assign(n, -1);
+        freeParticles.clear();
+        for (int i = 0; i < n; i++) {
+            if (invMass[i] == 0.0f) continue;
+            row[i] = (int)freeParticles.size();
+            freeParticles.push_back(i);
+        }
+        mass.resize(freeParticles.size());
+        for (size_t r = 0; r < freeParticles.size(); r++) mass[r] = 1.0f / invMass[freeParticles[r]];
+
+        stiffness.resize(numConstraints);
+        for (int k = 0; k < numConstraints; k++) stiffness[k] = 1.0f / std::max(constraints[k].compliance, minCompliance);
+
+        // 粒子 -> 约束的关联表，条目为约束编号 * 2 + 端点（0 为 i0，1 为 i1）
+        int rows = (int)freeParticles.size();
+        firstIncident.assign(rows + 1, 0);
+        for (const DistanceConstraint& c : constraints) {
+            if (row[c.i0] >= 0) firstIncident[row[c.i0] + 1]++;
+            if (row[c.i1] >= 0) firstIncident[row[c.i1] + 1]++;
+        }
+        for (int r = 0; r < rows; r++) firstIncident[r + 1] += firstIncident[r];
+        incident.resize(firstIncident[rows]);
+        std::vector<int> fill(firstIncident.begin(), firstIncident.end() - 1);
+        for (int k = 0; k < numConstraints; k++) {
+            const DistanceConstraint& c = constraints[k];
+            if (row[c.i0] >= 0) incident[fill[row[c.i0]]++] = k * 2;
+            if (row[c.i1] >= 0) incident[fill[row[c.i1]]++] = k * 2 + 1;
+        }
+
+        projection.resize(numConstraints);
+        inertia.resize(n);
+        rhs.resize(rows);
+        solution.resize(rows);
+        factored = false;
+    }
+
+    // 粒子重排后更新粒子和矩阵行之间的映射。矩阵的行按 build 时的顺序固定下来，分解不受粒子编号影响，不用重新分解
+    void remap(const std::vector<int>& oldToNew) {
+        std::vector<int> oldRow;
+        oldRow.swap(row);
+        row.assign(oldRow.size(), -1);
+        for (size_t i = 0; i < oldRow.size(); i++) row[oldToNew[i]] = oldRow[i];
+        for (int& i : freeParticles) i = oldToNew[i];
+        for (DistanceConstraint& c : constraints) {
+            c.i0 = oldToNew[c.i0];
+            c.i1 = oldToNew[c.i1];
+        }
+    }
+
+    // 子步开始时调用：记下预测位置 s。返回 false 表示还没有步长 dt 的分解，需要先调用 factor
+    bool beginSubStep(const std::vector<glm::vec3>& positions, float dt) {
+        inertia = positions;
+        return factored && factoredDt == dt;
+    }
+
+    // 为步长 dt 分解系统矩阵，替换之前的分解
+    bool factor(float dt) {
+        int rows = (int)freeParticles.size();
+        double h2 = double(dt) * dt;
+        std::vector<double> diagonal(rows);
+        for (int r = 0; r < rows; r++) diagonal[r] = mass[r] / h2;
+        std::vector<std::pair<std::pair<int, int>, double>> offDiagonal;
+        for (size_t k = 0; k < constraints.size(); k++) {
+            int r0 = row[constraints[k].i0], r1 = row[constraints[k].i1];
+            double w = stiffness[k];
+            if (r0 >= 0) diagonal[r0] += w;
+            if (r1 >= 0) diagonal[r1] += w;
+            if (r0 >= 0 && r1 >= 0 && r0 != r1) offDiagonal.push_back({ { r0, r1 }, -w });
+        }
+
+        factored = cholesky.factor(diagonal, offDiagonal);
+        factoredDt = dt;
+        if (!factored) return false;
+        return true;
+    }
+
+    // 一次 local + global 迭代，返回边长约束投影前的相对误差
+    ConstraintResidual iterate(std::vector<glm::vec3>& pos) {
+        int numConstraints = (int)constraints.size();
+        int rows = (int)freeParticles.size();
+        if (!factored) return ConstraintResidual();
+
+        // 1. local：投影到静止长度，存 p_k - A_k s
+        float maxError = 0.0f;
+        double sumSquared = 0.0;
+        #pragma omp parallel for schedule(static) reduction(max:maxError) reduction(+:sumSquared) if(numConstraints > 4096)
+        for (int k = 0; k < numConstraints; k++) {
+            const DistanceConstraint& c = constraints[k];
+            glm::vec3 d = pos[c.i0] - pos[c.i1];
+            float len = glm::length(d);
+            glm::vec3 p = len > 1e-6f ? d * (c.restLength / len) : d;
+            projection[k] = p - (inertia[c.i0] - inertia[c.i1]);
+            if (k < numStretch && c.restLength > 0.0f) {
+                float error = std::abs(len - c.restLength) / c.restLength;
+                maxError = std::max(maxError, error);
+                sumSquared += double(error) * error;
+            }
+        }
+
+        // 2. global：每个粒子收集右端项，解出位移
+        #pragma omp parallel for schedule(static) if(rows > 4096)
+        for (int r = 0; r < rows; r++) {
+            glm::vec3 b(0.0f);
+            for (int j = firstIncident[r]; j < firstIncident[r + 1]; j++) {
+                int entry = incident[j];
+                glm::vec3 g = stiffness[entry >> 1] * projection[entry >> 1];
+                if (entry & 1) b -= g;
+                else b += g;
+            }
+            rhs[r] = b;
+        }
+        cholesky.solve(rhs, solution);
+
+        #pragma omp parallel for schedule(static) if(rows > 4096)
+        for (int r = 0; r < rows; r++) {
+            int i = freeParticles[r];
+            pos[i] = inertia[i] + solution[r];
+        }
+        ConstraintResidual residual;
+        residual.maxError = maxError;
+        residual.sumSquared = sumSquared;
+        return residual;
+    }
+
+    size_t envelopeSize() const { return cholesky.envelopeSize(); }
+
+private:
+    std::vector<DistanceConstraint> constraints; // 先边长约束，后弯曲约束
+    int numStretch = 0;
+    std::vector<float> stiffness;     // 每条约束的 w = 1 / compliance
+    std::vector<int> row;             // 粒子在矩阵中的行号，静止粒子为 -1
+    std::vector<int> freeParticles;   // 每一行对应的粒子
+    std::vector<float> mass;
+    std::vector<int> firstIncident;   // 第 r 行的关联约束为 incident[firstIncident[r], firstIncident[r + 1])
+    std::vector<int> incident;
+    std::vector<glm::vec3> projection; // local 步每条约束的 p_k - A_k s（目标边向量减去预测位置的边向量）
+    std::vector<glm::vec3> inertia;    // 预测位置 s（静止粒子即它的固定位置），按粒子编号
+    std::vector<glm::vec3> rhs;
+    std::vector<glm::vec3> solution;
+    EnvelopeCholesky cholesky;
+    bool factored = false;
+    float factoredDt = 0.0f;           // 分解时的子步长 h
+};
+
+#endif
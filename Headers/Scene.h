@@ -0,0 +1,119 @@
+#pragma once
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "Mesh.h"
+#include "Model.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_set>
+
+// 合并所有模型的顶点和约束（GUI 和 headless 共用）
+// staticModelName 对应的模型的顶点全部视为静态粒子（如衣架）
+inline void gatherParticles(std::vector<Model>& models,
+                            std::vector<Vertex_H*>& allParticles,
+                            std::unordered_set<Vertex_H*>& staticParticles,
+                            std::vector<Edge*>& edges,
+                            std::vector<Edge*>& bendingEdges,
+                            const std::string& staticModelName = "Models/maoyi/qiu.obj")
+{
+    allParticles.clear();
+    staticParticles.clear();
+    edges.clear();
+    bendingEdges.clear();
+
+    for (auto &model : models)
+    {
+        bool isStaticModel = (model.name == staticModelName);
+        std::cout << "Model name: " << model.name << std::endl;
+        for (auto &mesh : model.meshes)
+        {
+            mesh.particleOffset = (int)allParticles.size(); // 网格的顶点在 allParticles 中连续存放
+            for (auto &vertex : mesh.vertices)
+            {
+                if(isStaticModel){
+                    //vertex.mass = 0.0f; // 静态模型的顶点质量设置为很大，避免移动
+                    staticParticles.insert(&vertex);
+                }
+                allParticles.push_back(&vertex);
+            }
+        }
+        for(auto &edge : model.edgeList){
+            edges.push_back(&edge);
+        }
+        for(auto &bendingEdge : model.bendingEdges){
+            bendingEdges.push_back(&bendingEdge);
+        }
+        printf("edge size: %zu\n", edges.size());
+    }
+}
+
+// 生成 nx x nz 的水平矩形网格，中心在 (0, height, 0)，相邻顶点间距 spacing，模型名为 "grid<nx>x<nz>"
+inline Model makeClothRect(int nx, int nz, float spacing = 0.5f, float height = 20.0f)
+{
+    vector<Vertex_H> vertices(nx * nz);
+    vector<unsigned int> indices;
+    float halfX = 0.5f * spacing * (nx - 1);
+    float halfZ = 0.5f * spacing * (nz - 1);
+
+    for (int z = 0; z < nz; z++) {
+        for (int x = 0; x < nx; x++) {
+            Vertex_H& vertex = vertices[z * nx + x];
+            vertex.Position = glm::vec3(x * spacing - halfX, height, z * spacing - halfZ);
+            vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            vertex.TexCoords = glm::vec2(float(x) / (nx - 1), float(z) / (nz - 1));
+            vertex.Velocity = glm::vec3(0.0f);
+            vertex.OldVelocity = glm::vec3(0.0f);
+            vertex.Acceleration = glm::vec3(0.0f);
+            vertex.OldPosition = vertex.Position;
+            vertex.initPosition = vertex.Position;
+            vertex.mass = 1.0f;
+            vertex.Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+            vertex.Bitangent = glm::vec3(0.0f, 0.0f, 1.0f);
+            for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+                vertex.m_BoneIDs[k] = 0;
+                vertex.m_Weights[k] = 0.0f;
+            }
+        }
+    }
+
+    for (int z = 0; z + 1 < nz; z++) {
+        for (int x = 0; x + 1 < nx; x++) {
+            unsigned int i = z * nx + x;
+            unsigned int row = (unsigned int)nx;
+            indices.insert(indices.end(), { i, i + row, i + 1 });
+            indices.insert(indices.end(), { i + 1, i + row, i + row + 1 });
+        }
+    }
+
+    return Model("grid" + std::to_string(nx) + "x" + std::to_string(nz), std::move(vertices), std::move(indices));
+}
+
+// 生成 n x n 的水平方形布料，中心在 (0, height, 0)，相邻顶点间距 spacing
+inline Model makeClothGrid(int n, float spacing = 0.5f, float height = 20.0f)
+{
+    Model grid = makeClothRect(n, n, spacing, height);
+    grid.name = "grid" + std::to_string(n);
+    return grid;
+}
+
+// 固定 makeClothGrid 布料 x 最小的一条边（质量为 0，即逆质量为 0），布料挂在这条边上下摆，返回固定的顶点数
+inline int pinClothGridEdge(Model& grid)
+{
+    float minX = 1e30f;
+    for (auto &mesh : grid.meshes)
+        for (auto &vertex : mesh.vertices) minX = std::min(minX, vertex.Position.x);
+    int pinned = 0;
+    for (auto &mesh : grid.meshes) {
+        for (auto &vertex : mesh.vertices) {
+            if (vertex.Position.x > minX + 1e-4f) continue;
+            vertex.mass = 0.0f;
+            pinned++;
+        }
+    }
+    return pinned;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef SIM_COUNTERS_H
+#define SIM_COUNTERS_H
+
+#include <vector>
+#include <algorithm>
+
+/*
+    求解器每帧的工作量统计
+    邻接表相关的数值在每次重建邻接表时更新，碰撞和约束误差每帧重新统计。
+    只有普通整数和浮点数，模拟线程可以整个拷贝进快照交给界面。
+*/
+struct SimCounters {
+    static constexpr int histogramBins = 16;     // 每个粒子邻接数量的直方图
+    static constexpr int histogramBinWidth = 4;  // 每格 4 个邻居，最后一格包含所有更多的
+
+    // 邻接表（最近一次重建）
+    long long neighborPairs = 0;     // adjIds 中使用的条目数（每对粒子计两次）
+    long long adjCapacity = 0;       // adjIds 的容量
+    int maxNeighbors = 0;            // 单个粒子最多的邻居数
+    int neighborHistogram[histogramBins] = {};
+
+    // 本帧
+    int subSteps = 0;                // 本帧的子步数（自适应子步时每帧不同）
+    int iterations = 0;              // 所有子步的约束迭代次数之和
+    int neighborRebuilds = 0;        // 本帧重建邻接表的次数
+    long long contacts = 0;          // 所有子步中实际推开的粒子对（从每个粒子一侧计）
+    long long contactCandidates = 0; // 所有子步中遍历的邻接表条目
+    long long tetherCorrections = 0; // 所有迭代中被挂接约束拉回的粒子
+    long long tethers = 0;           // 挂接约束总数（最近一次建立时）
+    float stretchErrorMax = 0.0f;    // 最后一个子步最后一次迭代中边长约束修正前的相对误差 |len - rest| / rest（求解核顺便统计）
+    float stretchErrorRms = 0.0f;
+
+    // Projective Dynamics 的矩阵分解（累计，不随帧清零）
+    int factorizations = 0;
+    int factorizationFailures = 0;   // 矩阵不正定，已退回 Gauss-Seidel
+    long long factorEnvelope = 0;    // 最近一次分解的 envelope 大小（L 存储的元素数）
+
+    // 每帧开始时清空本帧的统计，邻接表的统计保留
+    void beginFrame() {
+        iterations = 0;
+        neighborRebuilds = 0;
+        contacts = 0;
+        contactCandidates = 0;
+        tetherCorrections = 0;
+    }
+
+    float adjFill() const { return adjCapacity > 0 ? float(neighborPairs) / float(adjCapacity) : 0.0f; }
+
+    // 根据 CSR 的起始数组统计邻接表大小和分布
+    void recordNeighborLists(const std::vector<int>& firstAdjId, int particleCount, size_t capacity) {
+        neighborRebuilds++;
+        neighborPairs = particleCount > 0 ? firstAdjId[particleCount] : 0;
+        adjCapacity = (long long)capacity;
+        maxNeighbors = 0;
+        std::fill(neighborHistogram, neighborHistogram + histogramBins, 0);
+        for (int i = 0; i < particleCount; i++) {
+            int count = firstAdjId[i + 1] - firstAdjId[i];
+            maxNeighbors = std::max(maxNeighbors, count);
+            neighborHistogram[std::min(count / histogramBinWidth, histogramBins - 1)]++;
+        }
+    }
+};
+
+#endif
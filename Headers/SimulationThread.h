@@ -0,0 +1,127 @@
+#pragma once
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include "Simulator.h"
+#include "TripleBuffer.h"
+#include "FixedTimestep.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <omp.h>
+
+/*
+    独立的模拟线程
+    用 FixedTimestep 以固定步长调用 Simulator::simulate，每次走完几步后把粒子位置（按 allParticles 的顺序）写进三缓冲发布；
+    快照里同时带着最后一步之前的位置，渲染线程每帧在两者之间插值上传，法线由渲染线程根据插值结果重新计算。
+    两边互不等待：模拟慢时渲染照常刷新（显示上一份快照），渲染慢时模拟照常推进。
+    模拟线程运行时 Simulator 和 Model / Vertex_H 只归模拟线程所有，增删模型前必须先 stop()。
+*/
+class SimulationThread {
+public:
+    // 快照：最后一步之前和之后的位置，current 对应的墙上时间，以及最后一步的统计
+    struct Snapshot {
+        std::vector<glm::vec3> previous;
+        std::vector<glm::vec3> current;
+        std::chrono::steady_clock::time_point time;
+        SimCounters counters;
+    };
+
+    FixedTimestep timestep{ 1.0f / 60.0f }; // 固定步长和每次最多步数，start() 之前设置
+    int subSteps = 10;
+    int solverThreads = std::max(1, omp_get_num_procs() - 1); // 留一个核给渲染线程
+
+    explicit SimulationThread(Simulator& simulator) : simulator(simulator) {}
+    ~SimulationThread() { stop(); }
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start() {
+        if (worker.joinable()) return;
+        quit.store(false);
+        timestep.reset();
+        worker = std::thread(&SimulationThread::run, this);
+    }
+
+    // 等模拟线程做完当前一步再返回，之后可以安全地修改 Simulator
+    void stop() {
+        if (!worker.joinable()) return;
+        quit.store(true);
+        worker.join();
+    }
+
+    bool running() const { return worker.joinable(); }
+
+    // 渲染线程：有新快照时换到最新的一份，返回是否有新快照
+    bool update() { return snapshots.update(); }
+
+    // 渲染线程：按当前时间在快照的 previous 和 current 之间插值，结果按 allParticles 的顺序存放
+    // 还没有快照时返回 false
+    bool interpolatedPositions(std::vector<glm::vec3>& out) const {
+        const Snapshot& s = snapshots.readBuffer();
+        if (s.current.empty()) return false;
+        float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - s.time).count();
+        float alpha = std::min(std::max(elapsed / timestep.step, 0.0f), 1.0f);
+        out.resize(s.current.size());
+        for (size_t i = 0; i < out.size(); i++) out[i] = glm::mix(s.previous[i], s.current[i], alpha);
+        return true;
+    }
+
+    // 渲染线程：当前快照对应的求解器统计
+    const SimCounters& counters() const { return snapshots.readBuffer().counters; }
+
+    // 最近一步的耗时（毫秒），供界面显示
+    float lastStepMs() const { return stepMs.load(std::memory_order_relaxed); }
+
+    // 因为超过每次最多步数被丢掉的步数（累计）
+    long long droppedSteps() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    Simulator& simulator;
+    TripleBuffer<Snapshot> snapshots;
+    std::thread worker;
+    std::atomic<bool> quit{ false };
+    std::atomic<float> stepMs{ 0.0f };
+    std::atomic<long long> dropped{ 0 };
+
+    void run() {
+        using clock = std::chrono::steady_clock;
+        omp_set_num_threads(solverThreads); // 只影响本线程发起的并行区域
+
+        auto last = clock::now();
+        while (!quit.load(std::memory_order_relaxed)) {
+            auto now = clock::now();
+            int steps = timestep.advance(std::chrono::duration<float>(now - last).count());
+            last = now;
+
+            if (steps > 0) {
+                Snapshot& s = snapshots.writeBuffer();
+                for (int k = 0; k < steps; k++) {
+                    if (k == steps - 1) simulator.particles.copyPositionsInSourceOrder(s.previous);
+                    simulator.simulate(timestep.step, subSteps);
+                }
+                simulator.particles.copyPositionsInSourceOrder(s.current);
+                s.counters = simulator.counters;
+                // current 对应的时刻：累加器里剩下的时间已经过去了
+                s.time = clock::now() - std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<float>(timestep.alpha() * timestep.step));
+                snapshots.publish();
+
+                stepMs.store(std::chrono::duration<float, std::milli>(clock::now() - now).count() / steps, std::memory_order_relaxed);
+                dropped.store(timestep.droppedSteps, std::memory_order_relaxed);
+            }
+
+            // 睡到累加器攒够下一步
+            std::this_thread::sleep_until(last + std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<float>(timestep.timeToNextStep())));
+        }
+    }
+};
+
+#endif
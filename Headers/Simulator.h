@@ -2,9 +2,53 @@
 #include "Mesh.h"
 #include "Hash.h"
 #include "Model.h"
+#include "ParticleState.h"
+#include "ConstraintColoring.h"
+#include "DistanceConstraint.h"
+#include "DistanceKernel.h"
+#include "ParticleOrder.h"
+#include "Profiler.h"
+#include "SimCounters.h"
+#include "JacobiSolver.h"
+#include "ProjectiveDynamics.h"
+#include "TetherConstraints.h"
 #include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <chrono>
 #include <omp.h>
 
+// 各阶段的累计耗时（纳秒），benchmark 用
+struct PhaseTimings {
+    double predict = 0.0;
+    double hash = 0.0;
+    double ground = 0.0;
+    double constraints = 0.0;
+    double collisions = 0.0;
+    double velocity = 0.0;
+    double sync = 0.0;
+    long long frames = 0;
+    long long subSteps = 0;
+    long long neighborRebuilds = 0; // 邻接表重建次数
+
+    void reset() { *this = PhaseTimings(); }
+};
+
+// 距离约束的求解方式
+enum class SolverMode {
+    GaussSeidel, // 按着色批次逐批求解（默认）
+    Jacobi,      // 所有约束同时求解后按粒子平均，不需要着色，见 JacobiSolver
+    ProjectiveDynamics // local 投影 + 预分解矩阵的 global 求解，见 ProjectiveDynamicsSolver
+};
+
+inline const char* solverModeName(SolverMode mode) {
+    switch (mode) {
+    case SolverMode::Jacobi: return "jacobi";
+    case SolverMode::ProjectiveDynamics: return "projective-dynamics";
+    default: return "gauss-seidel";
+    }
+}
+
 class Simulator {
 public:
     std::vector<Vertex_H*>& allParticles;
@@ -13,27 +57,148 @@ public:
     std::unordered_set<Vertex_H*>& staticParticles;
     std::vector<Model>& models;
     float thickness = 0.8f; // 粒子厚度
+    float skin = 0.4f; // 邻接表的额外查询半径 (Verlet skin)
     Hash& hash;
-    int iterCount = 2;
+    int iterCount = 1; // 每个子步的约束迭代次数（设置了 iterationTolerance 时为上限）
+    float iterationTolerance = 0.0f; // 边长约束修正前的最大相对误差低于它时提前结束迭代，0 为总是迭代 iterCount 次
+    bool adaptiveSubSteps = false;   // 按最大速度选择子步数，simulate 的 numSubSteps 为上限（Projective Dynamics 模式下不起作用）
+    int minSubSteps = 2;
+    float maxSubStepTravel = 0.2f;   // 每个子步粒子最多移动 thickness 的多少倍（同时用于限制速度）
     glm::vec3 gravity = glm::vec3(0.0f, -9.8f, 0.0f);
 
+    ParticleState particles; // 求解器实际计算用的粒子数据 (SoA)
+    ConstraintColoring stretchColoring; // 边长约束的着色批次
+    ConstraintColoring bendingColoring; // 弯曲约束的着色批次
+    std::vector<DistanceConstraint> stretchConstraints; // 按颜色排序的边长约束
+    std::vector<DistanceConstraint> bendingConstraints; // 按颜色排序的弯曲约束
+    float stretchCompliance = 0.1f; // 边长约束柔度
+    float bendingCompliance = 1.0f; // 弯曲约束柔度
+    std::vector<float> stretchLambda; // 每条边长约束的 XPBD 拉格朗日乘子，和约束表同序
+    std::vector<float> bendingLambda;
+    SolverMode solverMode = SolverMode::GaussSeidel;
+    JacobiSolver jacobi;           // solverMode 为 Jacobi 时使用
+    bool jacobiValid = false;      // 关联表是否和当前的约束表、粒子编号一致
+    ProjectiveDynamicsSolver projective; // solverMode 为 ProjectiveDynamics 时使用
+    bool projectiveValid = false;  // 矩阵和分解是否和当前的约束表一致（重排粒子后 remap，不失效）
+    bool useTethers = true;        // 每次约束迭代前先求解挂接约束，见 TetherConstraints
+    TetherConstraints tethers;
+    bool tethersValid = false;     // 锚点是否和当前的约束表、静止粒子一致（重排粒子后 remap，不失效）
+    DistanceKernel::Isa simdIsa = DistanceKernel::detect(); // 距离约束用的 SIMD 指令集，构造后可以改，由调用方在配置完成后打印
+    static constexpr int kernelBlockSize = 256; // 每个线程一次处理的约束数量
+    bool spatialReorder = true; // 是否按 Morton 序重排粒子
+    int reorderInterval = 300;  // 每隔多少帧重排一次，0 为只在加载时重排
+    long long frameIndex = 0;   // 已模拟的帧数
+    bool syncVertices = true;   // 每帧是否把粒子状态写回 Vertex_H
+    PhaseTimings timings; // 各阶段耗时
+    SimCounters counters; // 每帧的工作量统计（邻接表、碰撞、约束误差）
+
+    std::vector<glm::vec3> neighborRefPosition; // 上次建立邻接表时的粒子位置
+    std::vector<glm::vec3> collisionDelta; // 每个粒子本次碰撞求解的位移
+    bool neighborsValid = false;
+
     Simulator(std::vector<Vertex_H*>& allParticles,
               std::vector<Edge *>& edges,
               std::vector<Edge *>& bendingEdges,
               std::unordered_set<Vertex_H*>& staticParticles,
               std::vector<Model>& models,
               Hash& hash)
-        : allParticles(allParticles), edges(edges), bendingEdges(bendingEdges),staticParticles(staticParticles), models(models), hash(hash) {}
+        : allParticles(allParticles), edges(edges), bendingEdges(bendingEdges),staticParticles(staticParticles), models(models), hash(hash) {
+        rebuild();
+    }
+
+    // 根据 allParticles 重新建立粒子状态、约束和着色（启动时，以及运行时增删模型后）
+    // 重建前粒子状态会同步回 Vertex_H，所以已有模型会从当前状态继续模拟
+    void rebuild() {
+        if (!syncVertices) particles.syncToVertices(); // 没有每帧同步时，先把当前状态写回
+        particles.build(allParticles, staticParticles);
+        buildConstraints();
+        if (spatialReorder) reorderParticles();
+        neighborsValid = false;
+    }
+
+    // 按当前位置的 Morton 序重排粒子，并把约束里的粒子下标换成新的编号
+    // 约束图的结构没有变，着色结果仍然有效；每种颜色内的约束按粒子下标排序，求解时顺序访问内存
+    void reorderParticles() {
+        ProfileScope scope(ProfilePhase::Reorder);
+        std::vector<int> newToOld = mortonOrder(particles.position);
+        std::vector<int> oldToNew(newToOld.size());
+        for (size_t i = 0; i < newToOld.size(); i++) oldToNew[newToOld[i]] = (int)i;
+
+        particles.permute(newToOld);
+        std::vector<int> stretchOldToNew = remapConstraints(stretchConstraints, stretchColoring, oldToNew);
+        std::vector<int> bendingOldToNew = remapConstraints(bendingConstraints, bendingColoring, oldToNew);
+        if (jacobiValid) jacobi.remap(newToOld, stretchOldToNew, bendingOldToNew);
+        if (projectiveValid) projective.remap(oldToNew); // 矩阵的行不变，只更新粒子编号，不重新分解
+        if (tethersValid) tethers.remap(newToOld, oldToNew);
+        neighborsValid = false; // 邻接表里是旧的编号，下次碰撞前重建
+    }
+
+    // 返回约束的新位置：旧的第 k 条约束现在是第 result[k] 条（端点的先后不变）
+    // coloring.order 跟着约束表一起换，仍然是表中每条约束对应的 Edge 下标
+    static std::vector<int> remapConstraints(std::vector<DistanceConstraint>& constraints, ConstraintColoring& coloring, const std::vector<int>& oldToNew) {
+        for (DistanceConstraint& c : constraints) {
+            c.i0 = oldToNew[c.i0];
+            c.i1 = oldToNew[c.i1];
+        }
+        std::vector<int> order(constraints.size());
+        for (size_t k = 0; k < order.size(); k++) order[k] = (int)k;
+        for (int c = 0; c < coloring.numColors(); c++) {
+            std::sort(order.begin() + coloring.colorStart[c], order.begin() + coloring.colorStart[c + 1],
+                      [&](int a, int b) {
+                          return std::min(constraints[a].i0, constraints[a].i1) < std::min(constraints[b].i0, constraints[b].i1);
+                      });
+        }
+        std::vector<DistanceConstraint> sorted(constraints.size());
+        std::vector<int> sortedOrder(constraints.size());
+        std::vector<int> constraintOldToNew(constraints.size());
+        for (size_t k = 0; k < order.size(); k++) {
+            sorted[k] = constraints[order[k]];
+            sortedOrder[k] = coloring.order[order[k]];
+            constraintOldToNew[order[k]] = (int)k;
+        }
+        constraints.swap(sorted);
+        coloring.order.swap(sortedOrder);
+        return constraintOldToNew;
+    }
+
+    // 初始化时从 Edge 建立约束表，并对约束图着色，同一颜色的约束可以并行求解
+    void buildConstraints() {
+        stretchConstraints = buildDistanceConstraints(edges, stretchCompliance);
+        colorDistanceConstraints(stretchConstraints, stretchColoring, (int)particles.size());
+
+        bendingConstraints = buildDistanceConstraints(bendingEdges, bendingCompliance);
+        colorDistanceConstraints(bendingConstraints, bendingColoring, (int)particles.size());
+
+        stretchLambda.assign(stretchConstraints.size(), 0.0f);
+        bendingLambda.assign(bendingConstraints.size(), 0.0f);
+        jacobiValid = false;
+        projectiveValid = false;
+        tethersValid = false;
+
+        printf("constraint colors: stretch %d, bending %d\n", stretchColoring.numColors(), bendingColoring.numColors());
+    }
 
     void simulate(float deltaTime, int numSubSteps) {
+        ProfileScope scope(ProfilePhase::Step);
+        frameIndex++;
+        counters.beginFrame();
+        // Projective Dynamics 的矩阵和子步长有关，子步数变化就要重新分解，所以固定用 numSubSteps
+        if (adaptiveSubSteps && solverMode != SolverMode::ProjectiveDynamics) numSubSteps = chooseSubSteps(deltaTime, numSubSteps);
+        counters.subSteps = numSubSteps;
+
         float dt = deltaTime / numSubSteps;
-        float maxVelocity = 0.2f * thickness / dt; // 经验公式， 限制速度的最大值，防止粒子移动太快穿透别的粒子或者地面
+        float maxVelocity = maxSubStepTravel * thickness / dt; // 经验公式， 限制速度的最大值，防止粒子移动太快穿透别的粒子或者地面
+
+        if (spatialReorder && reorderInterval > 0 && frameIndex % reorderInterval == 0) {
+            reorderParticles(); // 布料运动后空间顺序会慢慢打乱，定期重排
+        }
+
+        auto t = Profiler::Clock::now();
 
-        hash.clear(); // 清空哈希表
-        hash.insertParticles(allParticles);
-        hash.partialSum(); // 计算每个cell的粒子数量前缀和
-        hash.insertParticleMap(); // 将粒子指针插入到哈希表中
-        hash.queryAll(thickness);
+        std::vector<glm::vec3>& pos = particles.position;
+        std::vector<glm::vec3>& oldPos = particles.oldPosition;
+        std::vector<glm::vec3>& vel = particles.velocity;
+        int n = (int)particles.size();
 
         for (int i = 0; i < numSubSteps; ++i){
             // hash.clear();
@@ -42,24 +207,34 @@ public:
             // hash.insertParticleMap();
             // hash.queryAll(thickness); // 必须重建邻接表
             // 1. 预测新位置
-            for (auto& p : allParticles) {
-                if (staticParticles.count(p) || p->mass <= 0.0f) continue;
-                p->Velocity += gravity * dt;
-                float vel = glm::length(p->Velocity);
-                if (vel > maxVelocity) {
-                    p->Velocity = p->Velocity * (maxVelocity / vel); // 限制速度
+            for (int id = 0; id < n; id++) {
+                if (particles.invMass[id] == 0.0f) continue; // 静态粒子
+                vel[id] += gravity * dt;
+                float v = glm::length(vel[id]);
+                if (v > maxVelocity) {
+                    vel[id] = vel[id] * (maxVelocity / v); // 限制速度
                 }
-                p->OldPosition = p->Position;
-                p->Position += p->Velocity * dt;
+                oldPos[id] = pos[id];
+                pos[id] += vel[id] * dt;
             }
+            timings.predict += elapsedNs(t, ProfilePhase::Predict);
+
             // 2. 处理地面碰撞
             solveGroundCollision();
+            timings.ground += elapsedNs(t, ProfilePhase::Ground);
     
             // 3. 约束
             solveContraints(dt);
+            timings.constraints += elapsedNs(t, ProfilePhase::Constraints);
 
             // 4. 碰撞处理
+            // 邻接表以 thickness + skin 为半径建立，粒子移动不超过 skin / 2 时
+            // 任意两个粒子的相对位移不超过 skin，表中不会漏掉 thickness 以内的粒子对
+            if (needsNeighborRebuild()) rebuildNeighbors();
+            timings.hash += elapsedNs(t, ProfilePhase::Neighbors);
+
             solveCollisions(dt);
+            timings.collisions += elapsedNs(t, ProfilePhase::Collisions);
 
             // hash.clear();
             // hash.insertParticles(allParticles);
@@ -68,15 +243,75 @@ public:
             // hash.queryAndCollideAll(collisionRadius);
 
             // 5. 速度修正
-            for (auto& p : allParticles) {
-                if (staticParticles.count(p)) continue;
-                p->Velocity = (p->Position - p->OldPosition) / dt;
+            for (int id = 0; id < n; id++) {
+                if (particles.invMass[id] == 0.0f) continue;
+                vel[id] = (pos[id] - oldPos[id]) / dt;
             }
+            timings.velocity += elapsedNs(t, ProfilePhase::Velocity);
+            timings.subSteps++;
 
         }
 
+        // 把结果写回 Vertex_H；viewer 直接从 particles.position 上传 VBO 时可以关掉
+        if (syncVertices) particles.syncToVertices();
+        timings.sync += elapsedNs(t, ProfilePhase::Sync);
+        timings.frames++;
 
+    }
 
+    // 子步数：让最快的粒子每个子步移动不超过 maxSubStepTravel * thickness（和 maxVelocity 同一个经验公式）
+    // 速度按本帧结束时可能达到的值估计（加上重力在一帧内增加的速度），结果限制在 [minSubSteps, maxSubSteps]
+    int chooseSubSteps(float deltaTime, int maxSubSteps) {
+        const std::vector<glm::vec3>& vel = particles.velocity;
+        const std::vector<float>& invMass = particles.invMass;
+        int n = (int)particles.size();
+        float maxSpeed2 = 0.0f;
+        #pragma omp parallel for schedule(static) reduction(max:maxSpeed2) if(n > 4096)
+        for (int id = 0; id < n; id++) {
+            if (invMass[id] == 0.0f) continue;
+            maxSpeed2 = std::max(maxSpeed2, glm::dot(vel[id], vel[id]));
+        }
+        float maxSpeed = std::sqrt(maxSpeed2) + glm::length(gravity) * deltaTime;
+        int steps = (int)std::ceil(maxSpeed * deltaTime / (maxSubStepTravel * thickness));
+        return std::min(std::max(steps, std::max(minSubSteps, 1)), std::max(maxSubSteps, 1));
+    }
+
+    // 从上次建表起，是否有粒子移动超过 skin / 2
+    bool needsNeighborRebuild() {
+        if (!neighborsValid || neighborRefPosition.size() != particles.size()) return true;
+
+        const std::vector<glm::vec3>& pos = particles.position;
+        int n = (int)particles.size();
+        float maxDisp2 = 0.0f;
+        #pragma omp parallel for schedule(static) reduction(max:maxDisp2) if(n > 4096)
+        for (int id = 0; id < n; id++) {
+            glm::vec3 d = pos[id] - neighborRefPosition[id];
+            maxDisp2 = std::max(maxDisp2, glm::dot(d, d));
+        }
+        float halfSkin = 0.5f * skin;
+        return maxDisp2 > halfSkin * halfSkin;
+    }
+
+    void rebuildNeighbors() {
+        { ProfileScope scope(ProfilePhase::HashClear); hash.clear(); } // 清空哈希表
+        { ProfileScope scope(ProfilePhase::HashInsert); hash.insertParticles(particles.position); }
+        { ProfileScope scope(ProfilePhase::HashPrefix); hash.partialSum(); } // 计算每个cell的粒子数量前缀和
+        { ProfileScope scope(ProfilePhase::HashMap); hash.insertParticleMap(particles.position); } // 将粒子下标按 cell 顺序写入哈希表
+        { ProfileScope scope(ProfilePhase::HashQuery); hash.queryAll(particles.position, thickness + skin); }
+
+        neighborRefPosition = particles.position;
+        neighborsValid = true;
+        timings.neighborRebuilds++;
+        counters.recordNeighborLists(hash.firstAdjId, (int)particles.size(), hash.adjIds.size());
+    }
+
+    // 返回从 t 到现在的纳秒数，并把 t 更新为现在；这一段同时交给 profiler（关闭时不记录）
+    static double elapsedNs(Profiler::Clock::time_point& t, ProfilePhase phase) {
+        auto now = Profiler::Clock::now();
+        profiler().record(phase, t, now);
+        double ns = std::chrono::duration<double, std::nano>(now - t).count();
+        t = now;
+        return ns;
     }
 
     // void step(float deltaTime) {
@@ -224,138 +459,215 @@ public:
     // }
 
     void solveGroundCollision(){
-        for (auto& p : allParticles) {
-            if (staticParticles.count(p)) continue;
-            if (p->Position.y < 0.5f * p->radius) { // 如果y的坐标小于粒子半径，则产生地面碰撞
+        std::vector<glm::vec3>& pos = particles.position;
+        std::vector<glm::vec3>& oldPos = particles.oldPosition;
+        for (int id = 0; id < (int)particles.size(); id++) {
+            if (particles.invMass[id] == 0.0f) continue;
+            float r = particles.radius[id];
+            if (pos[id].y < 0.5f * r) { // 如果y的坐标小于粒子半径，则产生地面碰撞
                 float damping = 1.0f; // 阻尼系数
-                glm::vec3 dx = p->Position - p->OldPosition;
-                p->Position += dx * -damping; // 更新位置
-                p->Position.y = 0.5f * p->radius; // 确保粒子位置在地面上
+                glm::vec3 dx = pos[id] - oldPos[id];
+                pos[id] += dx * -damping; // 更新位置
+                pos[id].y = 0.5f * r; // 确保粒子位置在地面上
             }
         }
     }
 
+    // 按颜色依次处理约束表：串行批次整段调用 kernel(begin, end, true)，
+    // 其它颜色切成 kernelBlockSize 的块并行调用 kernel(blockBegin, blockEnd, false)
+    // kernel 返回这一段约束的 ConstraintResidual，这里合并所有块的结果
+    template <typename Kernel>
+    ConstraintResidual forEachColorBlock(const ConstraintColoring& coloring, Kernel kernel) {
+        float maxError = 0.0f;
+        double sumSquared = 0.0;
+        for (int c = 0; c < coloring.numColors(); c++) {
+            int begin = coloring.colorStart[c];
+            int end = coloring.colorStart[c + 1];
+            if (coloring.isSerial(c)) {
+                ConstraintResidual r = kernel(begin, end, true);
+                maxError = std::max(maxError, r.maxError);
+                sumSquared += r.sumSquared;
+                continue;
+            }
+            int numBlocks = (end - begin + kernelBlockSize - 1) / kernelBlockSize;
+            #pragma omp parallel for schedule(static) reduction(max:maxError) reduction(+:sumSquared) if(numBlocks > 1)
+            for (int b = 0; b < numBlocks; b++) {
+                int blockBegin = begin + b * kernelBlockSize;
+                int blockEnd = std::min(blockBegin + kernelBlockSize, end);
+                ConstraintResidual r = kernel(blockBegin, blockEnd, false);
+                maxError = std::max(maxError, r.maxError);
+                sumSquared += r.sumSquared;
+            }
+        }
+        ConstraintResidual residual;
+        residual.maxError = maxError;
+        residual.sumSquared = sumSquared;
+        return residual;
+    }
+
+    // 距离约束：edges 和 bendingEdges 共用，只有柔度不同
+    // 按颜色逐批求解，批内的约束没有共享粒子：按块分给 OpenMP 线程，块内用 SIMD 核
+    // 返回这一遍修正前的相对误差
+    ConstraintResidual solveDistanceConstraints(const std::vector<DistanceConstraint>& constraints, std::vector<float>& lambda, const ConstraintColoring& coloring, float dt){
+        float invDt2 = 1.0f / (dt * dt); // alpha = compliance / dt / dt
+        const DistanceConstraint* table = constraints.data();
+        float* lam = lambda.data();
+        float* pos = reinterpret_cast<float*>(particles.position.data());
+        const float* invMass = particles.invMass.data();
+
+        return forEachColorBlock(coloring, [&](int begin, int end, bool serial) {
+            if (serial) return DistanceKernel::solveScalar(pos, invMass, table, lam, begin, end, invDt2); // 串行批次里的约束可能共享粒子，不能用 SIMD
+            return DistanceKernel::solve(simdIsa, pos, invMass, table, lam, begin, end, invDt2);
+        });
+    }
+
+    // XPBD：lambda 每个子步开始时清零，在子步内跨迭代累加，刚度只取决于 compliance 和 dt，不再随迭代次数变化
+    // 不跨子步热启动：上一子步约束产生的位移已经通过速度进了这一子步的预测位置，再按旧的 lambda 移一次粒子就施加了两遍
+    // 设置了 iterationTolerance 时，边长约束在某一遍开始时的误差已经低于容差就不再继续迭代
+    // 每一遍的边长误差由求解核顺便统计，写进 counters，帧结束时留下的是最后一个子步最后一遍的误差
     void solveContraints(float dt){
-        for (auto& e : edges){
-            //printf("edge a Pos: %f, %f, %f, b Pos: %f, %f, %f, lenght: %f\n", e[0].v0->Position.x, e[0].v0->Position.y, e[0].v0->Position.z, e[0].v1->Position.x, e[0].v1->Position.y, e[0].v1->Position.z, e[0].lenght);
-            //for(int i = 0; i < edges.size(); i++){
-                //Edge& edge = edges[i];
-                Vertex_H* p0 = e->v0;
-                Vertex_H* p1 = e->v1;
-                float restLength = e->lenght;
-                float w0 = staticParticles.count(p0) ? 0.0f : 1.0f / p0->mass;
-                float w1 = staticParticles.count(p1) ? 0.0f : 1.0f / p1->mass;
-
-                float w = w0 + w1;
-                if(w == 0.0f) continue; // 避免除以0
-
-                glm::vec3 diff = p0->Position - p1->Position; //   Xi - Xj
-                float len = glm::length(diff);                // ||Xi - Xj||
-                if(len < 1e-6f) continue; // 避免除以0
-                glm::vec3 dir = diff / len;
-
-                float C = len - restLength;                   // ||Xi - Xj|| - restLength
-                //printf("C: %f\n", C);
-                //float alpha = 0.0001f; // compliances / dt / dt;
-                float alpha = 0.1f / dt / dt; // compliances / dt / dt;
-                float s = -C / (w + alpha); // 计算位移
-                p0->Position += dir * s * w0; // 更新位置
-                p1->Position -= dir * s * w1; // 更新位置
-
-            //}
+        if (solverMode == SolverMode::ProjectiveDynamics) {
+            solveContraintsProjective(dt);
+            return;
+        }
+        std::fill(stretchLambda.begin(), stretchLambda.end(), 0.0f);
+        std::fill(bendingLambda.begin(), bendingLambda.end(), 0.0f);
+        if (solverMode == SolverMode::Jacobi) {
+            solveContraintsJacobi(dt);
+            return;
         }
+        for (int iter = 0; iter < iterCount; iter++) {
+            solveTethers();
+            ConstraintResidual stretchError = solveDistanceConstraints(stretchConstraints, stretchLambda, stretchColoring, dt);
+            solveDistanceConstraints(bendingConstraints, bendingLambda, bendingColoring, dt);
+            recordStretchResidual(stretchError);
+            if (iterationTolerance > 0.0f && stretchError.maxError < iterationTolerance) break;
+        }
+    }
 
-        for (auto& e : bendingEdges){
-            //printf("edge a Pos: %f, %f, %f, b Pos: %f, %f, %f, lenght: %f\n", e[0].v0->Position.x, e[0].v0->Position.y, e[0].v0->Position.z, e[0].v1->Position.x, e[0].v1->Position.y, e[0].v1->Position.z, e[0].lenght);
-            //for(int i = 0; i < edges.size(); i++){
-                //Edge& edge = edges[i];
-                Vertex_H* p0 = e->v0;
-                Vertex_H* p1 = e->v1;
-                float restLength = e->lenght;
-                float w0 = staticParticles.count(p0) ? 0.0f : 1.0f / p0->mass;
-                float w1 = staticParticles.count(p1) ? 0.0f : 1.0f / p1->mass;
-
-                float w = w0 + w1;
-                if(w == 0.0f) continue; // 避免除以0
-
-                glm::vec3 diff = p0->Position - p1->Position; //   Xi - Xj
-                float len = glm::length(diff);                // ||Xi - Xj||
-                if(len < 1e-6f) continue; // 避免除以0
-                glm::vec3 dir = diff / len;
-
-                float C = len - restLength;                   // ||Xi - Xj|| - restLength
-                //printf("C: %f\n", C);
-                //float alpha = 0.01f; // compliances / dt / dt;
-                float alpha = 1.0f / dt / dt; // compliances / dt / dt;
-                float s = -C / (w + alpha); // 计算位移
-                p0->Position += dir * s * w0; // 更新位置
-                p1->Position -= dir * s * w1; // 更新位置
-
-            //}
+    // Jacobi 模式：边长和弯曲约束在同一次迭代里一起求解，迭代次数和提前结束的规则同上
+    void solveContraintsJacobi(float dt){
+        if (!jacobiValid) {
+            jacobi.build((int)particles.size(), stretchConstraints, bendingConstraints);
+            jacobiValid = true;
+        }
+        float invDt2 = 1.0f / (dt * dt);
+        jacobi.beginSubStep(particles.position);
+        for (int iter = 0; iter < iterCount; iter++) {
+            solveTethers();
+            ConstraintResidual stretchError = jacobi.iterate(particles.position, particles.invMass,
+                                                             stretchConstraints, stretchLambda, bendingConstraints, bendingLambda, invDt2);
+            recordStretchResidual(stretchError);
+            if (iterationTolerance > 0.0f && stretchError.maxError < iterationTolerance) break;
+        }
+    }
+
+    // Projective Dynamics 模式：不用 lambda，迭代次数和提前结束的规则同上
+    // 加载、重建约束之后，或者子步长变了时分解矩阵；这个模式下子步数固定，正常运行时只分解一次
+    void solveContraintsProjective(float dt){
+        if (!projectiveValid) {
+            projective.build(particles.invMass, stretchConstraints, bendingConstraints);
+            projectiveValid = true;
+        }
+        if (!projective.beginSubStep(particles.position, dt)) {
+            ProfileScope scope(ProfilePhase::Factorize);
+            bool ok = projective.factor(dt);
+            counters.factorizations++;
+            counters.factorEnvelope = (long long)projective.envelopeSize();
+            if (!ok) {
+                counters.factorizationFailures++;
+                solverMode = SolverMode::GaussSeidel;
+                solveContraints(dt);
+                return;
+            }
+        }
+        for (int iter = 0; iter < iterCount; iter++) {
+            ConstraintResidual stretchError = projective.iterate(particles.position);
+            solveTethers(); // global 步从预测位置重新解出所有粒子，挂接约束要放在它之后才不会被覆盖
+            recordStretchResidual(stretchError);
+            if (iterationTolerance > 0.0f && stretchError.maxError < iterationTolerance) break;
         }
-        
     }
 
+    // 挂接约束：粒子到最近静止粒子的直线距离不超过沿网格的距离（衣服和衣架不相连时从接触的地方算起），三种求解方式的每次迭代都调用
+    void solveTethers(){
+        if (!useTethers) return;
+        if (!tethersValid) {
+            tethers.build(particles.invMass, stretchConstraints, particles.initPosition);
+            tethersValid = true;
+            counters.tethers = (long long)tethers.size();
+        }
+        counters.tetherCorrections += tethers.solve(particles.position);
+    }
+
+    // 一次迭代结束：计数，并记下这一遍边长约束修正前的误差
+    void recordStretchResidual(const ConstraintResidual& stretchError) {
+        counters.iterations++;
+        counters.stretchErrorMax = stretchError.maxError;
+        counters.stretchErrorRms = stretchError.rms(stretchConstraints.size());
+    }
+
+    // 自碰撞 (Jacobi)：每个粒子遍历自己的邻接表，只累加自己的位移到 collisionDelta，
+    // 取平均后统一写回，没有两个线程写同一个粒子，可以直接并行
     void solveCollisions(float dt){
+        std::vector<glm::vec3>& pos = particles.position;
+        std::vector<glm::vec3>& oldPos = particles.oldPosition;
+        std::vector<glm::vec3>& initPos = particles.initPosition;
+        std::vector<float>& invMass = particles.invMass;
+        int n = (int)particles.size();
         float thickness2 = thickness * thickness;
+        float friction = 0.1f; // 摩擦系数
 
-        for(int id0 = 0; id0 < allParticles.size(); id0++){
-            Vertex_H* particle0 = allParticles[id0];
-            if(particle0->mass == 0.0f) continue; // 跳过质量为0的粒子
+        if((int)collisionDelta.size() != n) collisionDelta.resize(n);
+
+        long long contacts = 0, candidates = 0;
+        #pragma omp parallel for schedule(dynamic, 256) if(n > 1024) reduction(+:contacts, candidates)
+        for(int id0 = 0; id0 < n; id0++){
+            collisionDelta[id0] = glm::vec3(0.0f);
+            float w0 = invMass[id0];
+            if(w0 == 0.0f) continue; // 跳过质量为0的粒子
 
             int first = hash.firstAdjId[id0]; // 获取第一个邻接粒子的位置
             int last = hash.firstAdjId[id0 + 1]; // 获取最后一个邻接粒子的位置
+            candidates += last - first;
 
-            if(last > hash.adjIds.size() || first < 0 || last < first) {
-                std::cout << "Error: Invalid range for adjIds. first: " << first << ", last: " << last << ", size: " << hash.adjIds.size() << std::endl;
-                continue; // 如果范围不合法，跳过
-            }
-
+            glm::vec3 delta(0.0f);
+            int count = 0;
             for(int j = first; j < last; j++){
                 int id1 = hash.adjIds[j]; // 获取邻接粒子的索引
-                Vertex_H* particle1 = allParticles[id1]; // 获取邻接粒子
-                if(particle1->mass == 0.0f || id0 == id1) continue; // 跳过质量为0的粒子
-
-                glm::vec3 diff = particle1->Position - particle0->Position; // 计算两个粒子之间的差向量
-            
-                float dist = glm::length(diff); // 计算距离的平方
 
-                //printf("dist: %f, thickness: %f\n", dist, thickness);
-                float dist2 = dist * dist; // 平方距离
+                glm::vec3 diff = pos[id0] - pos[id1]; // 从邻接粒子指向自己
+                float dist2 = glm::dot(diff, diff);
+                if(dist2 > thickness2 || dist2 == 0.0f) continue; // 如果距离大于厚度或者距离为0，则跳过
 
-                if(dist2 > thickness2 || dist2 == 0.0f) continue; // 如果距离大于厚度的平方或者距离为0，则跳过
+                // 初始就比 thickness 近的粒子（如同一三角形的顶点）只保持初始距离
+                float minDist = thickness;
+                glm::vec3 restDiff = initPos[id0] - initPos[id1];
+                float restDist2 = glm::dot(restDiff, restDiff);
+                if(restDist2 < thickness2) minDist = std::sqrt(restDist2);
 
-                float restDist = glm::length(particle0->initPosition - particle1->initPosition); // 计算初始位置的平方距离
-                float restDist2 = restDist * restDist; // 平方距离
+                float dist = std::sqrt(dist2);
+                if(dist >= minDist) continue;
 
-                float minDist = thickness; // 最小距离 thickness = 0.01f
+                // 位置修正：按逆质量分配，自己承担 w0 / (w0 + w1)
+                float w1 = invMass[id1];
+                delta += diff * ((minDist - dist) / dist * w0 / (w0 + w1));
 
-                if(dist2 > thickness2) continue; // 如果距离大于厚度的平方，则跳过
-
-                if(restDist2 < thickness2)
-                    minDist = restDist;
-
-                // 位置修正
-                diff = diff * (minDist - dist / dist); // 计算新的位置差向量
-                particle0->Position -= diff * 0.5f; // 更新位置
-                particle1->Position += diff * 0.5f; // 更新邻接粒子的位置
-                //printf("yes\n");
-
-                // 速度修正
-                glm::vec3 diffNewOld0 = particle0->Position - particle0->OldPosition; // 计算位置差向量
-                glm::vec3 diffNewOld1 = particle1->Position - particle1->OldPosition; // 计算邻接粒子的位置差向量
-
-                glm::vec3 averageVelocity = (diffNewOld0 + diffNewOld1) * 0.5f; // 计算平均速度
-
-                diffNewOld0 = averageVelocity - diffNewOld0; // 计算新的位置差向量
-                diffNewOld1 = averageVelocity - diffNewOld1; // 计算邻接粒子的新的位置差向量
-
-                float friction = 0.1f; // 摩擦系数
-
-                particle0->Position += diffNewOld0 * friction; // 更新位置
-                particle1->Position += diffNewOld1 * friction; // 更新邻接粒子的位置
+                // 速度修正（摩擦）：向两者的平均位移靠拢
+                glm::vec3 dx0 = pos[id0] - oldPos[id0];
+                glm::vec3 dx1 = pos[id1] - oldPos[id1];
+                delta += ((dx0 + dx1) * 0.5f - dx0) * friction;
+                count++;
             }
+            if(count > 0) collisionDelta[id0] = delta / float(count);
+            contacts += count;
+        }
+        counters.contacts += contacts;
+        counters.contactCandidates += candidates;
 
+        #pragma omp parallel for schedule(static) if(n > 4096)
+        for(int id = 0; id < n; id++){
+            pos[id] += collisionDelta[id];
         }
     }
 
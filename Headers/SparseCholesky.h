@@ -0,0 +1,174 @@
+#pragma once
+#ifndef SPARSE_CHOLESKY_H
+#define SPARSE_CHOLESKY_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+/*
+    对称正定稀疏矩阵的 Cholesky 分解 (envelope / skyline 存储)
+    先用 Reverse Cuthill-McKee 重排把非零元集中到对角线附近，
+    然后每一行只存从第一个非零列到对角线的连续一段，分解后的 L 和 A 的 envelope 相同（不产生 envelope 外的填充）。
+    布料网格重排后的带宽大约是网格一条边上的顶点数，分解一次 O(n * b^2)，每次求解 O(n * b)。
+    右端项为 glm::vec3，三个坐标共用一次分解。
+*/
+
+// Reverse Cuthill-McKee：adjacency[i] 为节点 i 的邻居，返回 order，order[k] 为新的第 k 个节点
+inline std::vector<int> reverseCuthillMcKee(const std::vector<std::vector<int>>& adjacency) {
+    int n = (int)adjacency.size();
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> visited(n, 0);
+    std::vector<int> neighbors;
+
+    // 从 start 做一次 BFS，返回最后访问到的层里度数最小的节点（伪外围节点）
+    // level 和 frontier 在所有调用之间共用，结束时只把这次访问到的节点恢复成 -1，每次调用只花连通分量大小的时间
+    std::vector<int> level(n, -1);
+    std::vector<int> frontier;
+    frontier.reserve(n);
+    auto farthest = [&](int start) {
+        frontier.clear();
+        frontier.push_back(start);
+        level[start] = 0;
+        int best = start;
+        for (size_t head = 0; head < frontier.size(); head++) {
+            int v = frontier[head];
+            if (level[v] > level[best] || (level[v] == level[best] && adjacency[v].size() < adjacency[best].size())) best = v;
+            for (int u : adjacency[v]) {
+                if (level[u] < 0) { level[u] = level[v] + 1; frontier.push_back(u); }
+            }
+        }
+        for (int v : frontier) level[v] = -1;
+        return best;
+    };
+
+    for (int seed = 0; seed < n; seed++) {
+        if (visited[seed]) continue;
+        // 每个连通分量从伪外围节点开始
+        int start = farthest(farthest(seed));
+        size_t head = order.size();
+        order.push_back(start);
+        visited[start] = 1;
+        while (head < order.size()) {
+            int v = order[head++];
+            neighbors.clear();
+            for (int u : adjacency[v]) {
+                if (!visited[u]) { visited[u] = 1; neighbors.push_back(u); }
+            }
+            std::sort(neighbors.begin(), neighbors.end(), [&](int a, int b) { return adjacency[a].size() < adjacency[b].size(); });
+            order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+class EnvelopeCholesky {
+public:
+    static constexpr double flushToZero = 1e-150; // 比它小的 L 元素置 0，两个这样的数相乘仍然是正常的 double
+
+    // 分解 A：diagonal[i] 为对角元，offDiagonal 为下三角（或上三角）的非零元 (i, j, value)，i != j
+    // 返回 false 表示矩阵不是正定的
+    bool factor(const std::vector<double>& diagonal, const std::vector<std::pair<std::pair<int, int>, double>>& offDiagonal) {
+        n = (int)diagonal.size();
+
+        // 1. RCM 重排
+        std::vector<std::vector<int>> adjacency(n);
+        for (const auto& entry : offDiagonal) {
+            int i = entry.first.first, j = entry.first.second;
+            adjacency[i].push_back(j);
+            adjacency[j].push_back(i);
+        }
+        for (std::vector<int>& list : adjacency) {
+            std::sort(list.begin(), list.end());
+            list.erase(std::unique(list.begin(), list.end()), list.end());
+        }
+        order = reverseCuthillMcKee(adjacency);
+        position.resize(n);
+        for (int k = 0; k < n; k++) position[order[k]] = k;
+
+        // 2. 每一行的 envelope：第一个非零列
+        first.resize(n);
+        for (int k = 0; k < n; k++) first[k] = k;
+        for (const auto& entry : offDiagonal) {
+            int a = position[entry.first.first], b = position[entry.first.second];
+            int row = std::max(a, b), col = std::min(a, b);
+            first[row] = std::min(first[row], col);
+        }
+        rowStart.resize(n + 1);
+        rowStart[0] = 0;
+        for (int k = 0; k < n; k++) rowStart[k + 1] = rowStart[k] + (k - first[k] + 1);
+        values.assign(rowStart[n], 0.0);
+
+        for (int i = 0; i < n; i++) at(position[i], position[i]) = diagonal[i];
+        for (const auto& entry : offDiagonal) {
+            int a = position[entry.first.first], b = position[entry.first.second];
+            at(std::max(a, b), std::min(a, b)) += entry.second;
+        }
+
+        // 3. 按行分解：L(i, j) = (A(i, j) - sum_k L(i, k) L(j, k)) / L(j, j)，k 取两行 envelope 的交集
+        // 质量项占优（M / h^2 远大于刚度）时，填充的元素随着离对角线的距离按几何级数衰减，很快进入非规格化数，
+        // 非规格化数的乘加比正常的慢几十倍（分解和每次求解都是），所以把绝对值小于 flushToZero 的元素直接置 0
+        for (int i = 0; i < n; i++) {
+            double* rowI = &values[rowStart[i]] - first[i]; // rowI[j] 即 L(i, j)
+            for (int j = first[i]; j < i; j++) {
+                const double* rowJ = &values[rowStart[j]] - first[j];
+                double sum = rowI[j];
+                for (int k = std::max(first[i], first[j]); k < j; k++) sum -= rowI[k] * rowJ[k];
+                rowI[j] = flush(sum / rowJ[j]);
+            }
+            double d = rowI[i];
+            for (int k = first[i]; k < i; k++) d -= rowI[k] * rowI[k];
+            if (d <= 0.0) return false;
+            rowI[i] = std::sqrt(d);
+        }
+        return true;
+    }
+
+    // 解 A x = b，b 和 x 按原来的编号
+    void solve(const std::vector<glm::vec3>& b, std::vector<glm::vec3>& x) {
+        work.resize(n);
+        for (int k = 0; k < n; k++) work[k] = glm::dvec3(b[order[k]]);
+
+        // L y = b。右端项只在少数行上不为 0 时，解同样按几何级数衰减，和分解一样把很小的分量置 0
+        for (int i = 0; i < n; i++) {
+            const double* rowI = &values[rowStart[i]] - first[i];
+            glm::dvec3 sum = work[i];
+            for (int k = first[i]; k < i; k++) sum -= rowI[k] * work[k];
+            work[i] = flush(sum / rowI[i]);
+        }
+        // L^T x = y，按列向前消去
+        for (int i = n - 1; i >= 0; i--) {
+            const double* rowI = &values[rowStart[i]] - first[i];
+            work[i] = flush(work[i] / rowI[i]);
+            glm::dvec3 xi = work[i];
+            for (int k = first[i]; k < i; k++) work[k] -= rowI[k] * xi;
+        }
+
+        x.resize(n);
+        for (int k = 0; k < n; k++) x[order[k]] = glm::vec3(work[k]);
+    }
+
+    int size() const { return n; }
+    size_t envelopeSize() const { return values.size(); } // L 的非零元（含 envelope 内的 0）
+
+private:
+    int n = 0;
+    std::vector<int> order;      // 新的第 k 行是原来的第 order[k] 行
+    std::vector<int> position;   // 原来的第 i 行在新编号中的位置
+    std::vector<int> first;      // 每一行第一个存储的列
+    std::vector<size_t> rowStart;
+    std::vector<double> values;  // 逐行存放 L(i, first[i] .. i)
+    std::vector<glm::dvec3> work;
+
+    double& at(int i, int j) { return values[rowStart[i] + (j - first[i])]; }
+
+    static double flush(double v) { return std::abs(v) < flushToZero ? 0.0 : v; }
+    static glm::dvec3 flush(const glm::dvec3& v) { return glm::dvec3(flush(v.x), flush(v.y), flush(v.z)); }
+};
+
+#endif
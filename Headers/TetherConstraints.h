@@ -0,0 +1,222 @@
+#pragma once
+#ifndef TETHER_CONSTRAINTS_H
+#define TETHER_CONSTRAINTS_H
+
+#include <glm/glm.hpp>
+#include "DistanceConstraint.h"
+
+#include <vector>
+#include <queue>
+#include <tuple>
+#include <functional>
+#include <algorithm>
+#include <unordered_map>
+#include <limits>
+#include <cstdint>
+#include <omp.h>
+
+/*
+    长程挂接约束 (Long Range Attachments, Kim et al. 2012)
+    挂在静止粒子（衣架、固定点）上的布料，拉伸信息每次迭代只沿约束传一条边，迭代不够时整块布会被重力拉长。
+    预先沿边长约束的网格图做多源 Dijkstra，找出每个动态粒子测地距离最近的 maxAnchors 个静止粒子，
+    求解时只在粒子离锚点的直线距离超过测地距离时把它拉回（单侧约束），不会阻止布料弯曲、折叠。
+    每个粒子只改自己的位置，按粒子并行，不需要着色。
+    和静止粒子不连通的部分（衣架是单独的静态模型，和衣服没有共享的边）从离静止粒子最近的一圈粒子进入：
+    这些入口粒子到最近静止粒子的直线距离（静止状态）作为初始距离，再沿网格传播，上限仍然不小于静止状态下的直线距离。
+    整个部分离静止粒子都超过 contactDistance 时（单独放在场景里的衣服）没有挂接约束。
+*/
+struct Tether {
+    int anchor;         // 静止粒子
+    float maxDistance;  // 沿网格的测地距离 * (1 + slack)
+};
+
+class TetherConstraints {
+public:
+    int maxAnchors = 1;    // 每个粒子挂到最近的几个静止粒子
+    float slack = 0.0f;    // 允许超出测地距离的比例
+    float contactDistance = 3.0f; // 不和静止粒子连通的部分，离静止粒子最近不超过这个距离才挂上去
+    float contactBand = 1.0f;     // 这部分里离静止粒子不超过 最近距离 + contactBand 的粒子都作为入口
+
+    // 根据边长约束建立网格图，从所有静止粒子出发求每个粒子最近的 maxAnchors 个锚点
+    // restPosition 为静止状态的位置，用来把不连通的部分挂到附近的静止粒子上
+    // 约束表或静止粒子变化后需要重新调用，粒子重排只需要 remap
+    void build(const std::vector<float>& invMass, const std::vector<DistanceConstraint>& stretch, const std::vector<glm::vec3>& restPosition) {
+        int n = (int)invMass.size();
+        int k = std::max(1, maxAnchors);
+
+        // 网格图 (CSR)，边权为静止长度
+        std::vector<int> firstEdge(n + 1, 0);
+        for (const DistanceConstraint& c : stretch) {
+            firstEdge[c.i0 + 1]++;
+            firstEdge[c.i1 + 1]++;
+        }
+        for (int i = 0; i < n; i++) firstEdge[i + 1] += firstEdge[i];
+        std::vector<std::pair<int, float>> graph(firstEdge[n]);
+        std::vector<int> fill(firstEdge.begin(), firstEdge.end() - 1);
+        for (const DistanceConstraint& c : stretch) {
+            graph[fill[c.i0]++] = { c.i1, c.restLength };
+            graph[fill[c.i1]++] = { c.i0, c.restLength };
+        }
+
+        // 多源 Dijkstra：每个粒子最多接受 k 个来自不同锚点的标号，按距离从小到大确定，所以就是最近的 k 个
+        std::vector<int> labelCount(n, 0);
+        std::vector<Tether> labels((size_t)n * k);
+        using Entry = std::tuple<float, int, int>; // 距离，粒子，锚点
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+        auto propagate = [&]() {
+            while (!queue.empty()) {
+                auto [dist, i, anchor] = queue.top();
+                queue.pop();
+                Tether* own = &labels[(size_t)i * k];
+                if (labelCount[i] == k) continue;
+                if (std::any_of(own, own + labelCount[i], [&](const Tether& t) { return t.anchor == anchor; })) continue;
+                own[labelCount[i]++] = { anchor, dist };
+                for (int e = firstEdge[i]; e < firstEdge[i + 1]; e++) {
+                    int j = graph[e].first;
+                    if (labelCount[j] < k) queue.emplace(dist + graph[e].second, j, anchor);
+                }
+            }
+        };
+        for (int i = 0; i < n; i++) {
+            if (invMass[i] == 0.0f) queue.emplace(0.0f, i, i);
+        }
+        propagate();
+
+        // 没有标号的动态粒子和静止粒子不连通：按连通分量从最近的一圈粒子挂到静止粒子上，再传播一次
+        // 这些分量和已经有标号的粒子之间没有边，第二次传播不会改动第一次的结果
+        std::vector<int> nearestAnchor;
+        std::vector<float> nearestDistance;
+        findNearestStatic(invMass, labelCount, restPosition, nearestAnchor, nearestDistance);
+        std::vector<int> component(n, -1);
+        std::vector<int> members;
+        for (int seed = 0; seed < n; seed++) {
+            if (invMass[seed] == 0.0f || labelCount[seed] > 0 || component[seed] >= 0) continue;
+            members.clear();
+            members.push_back(seed);
+            component[seed] = seed;
+            float closest = nearestDistance[seed];
+            for (size_t m = 0; m < members.size(); m++) {
+                int i = members[m];
+                closest = std::min(closest, nearestDistance[i]);
+                for (int e = firstEdge[i]; e < firstEdge[i + 1]; e++) {
+                    int j = graph[e].first;
+                    if (component[j] < 0) {
+                        component[j] = seed;
+                        members.push_back(j);
+                    }
+                }
+            }
+            if (closest > contactDistance) continue;
+            for (int i : members) {
+                if (nearestDistance[i] <= closest + contactBand) queue.emplace(nearestDistance[i], i, nearestAnchor[i]);
+            }
+        }
+        propagate();
+
+        // 只有动态粒子需要挂接约束，按粒子连续存放
+        firstTether.assign(n + 1, 0);
+        tethers.clear();
+        for (int i = 0; i < n; i++) {
+            if (invMass[i] != 0.0f) {
+                for (int t = 0; t < labelCount[i]; t++) {
+                    Tether tether = labels[(size_t)i * k + t];
+                    tether.maxDistance *= 1.0f + slack;
+                    tethers.push_back(tether);
+                }
+            }
+            firstTether[i + 1] = (int)tethers.size();
+        }
+    }
+
+    // 粒子重排后换成新的编号。锚点和测地距离不随编号变化，不用重新搜索
+    void remap(const std::vector<int>& newToOld, const std::vector<int>& oldToNew) {
+        int n = (int)newToOld.size();
+        std::vector<int> oldFirst;
+        std::vector<Tether> oldTethers;
+        oldFirst.swap(firstTether);
+        oldTethers.swap(tethers);
+
+        firstTether.resize(n + 1);
+        tethers.reserve(oldTethers.size());
+        firstTether[0] = 0;
+        for (int i = 0; i < n; i++) {
+            int old = newToOld[i];
+            for (int t = oldFirst[old]; t < oldFirst[old + 1]; t++) {
+                Tether tether = oldTethers[t];
+                tether.anchor = oldToNew[tether.anchor];
+                tethers.push_back(tether);
+            }
+            firstTether[i + 1] = (int)tethers.size();
+        }
+    }
+
+    // 把超出最大距离的粒子沿直线拉回，返回被拉回的粒子数
+    int solve(std::vector<glm::vec3>& pos) {
+        int n = (int)firstTether.size() - 1;
+        int active = 0;
+        if (tethers.empty()) return 0;
+        #pragma omp parallel for schedule(static) reduction(+:active) if(n > 4096)
+        for (int i = 0; i < n; i++) {
+            bool moved = false;
+            for (int t = firstTether[i]; t < firstTether[i + 1]; t++) {
+                glm::vec3 d = pos[i] - pos[tethers[t].anchor];
+                float len = glm::length(d);
+                if (len <= tethers[t].maxDistance) continue;
+                pos[i] -= d * (1.0f - tethers[t].maxDistance / len);
+                moved = true;
+            }
+            if (moved) active++;
+        }
+        return active;
+    }
+
+    size_t size() const { return tethers.size(); }
+
+private:
+    std::vector<int> firstTether;  // 粒子 i 的挂接约束为 tethers[firstTether[i], firstTether[i + 1])
+    std::vector<Tether> tethers;
+
+    // 还没有标号的动态粒子到 contactDistance + contactBand 以内最近的静止粒子（没有时距离为无穷大），
+    // 静止粒子按 contactDistance + contactBand 大小的格子分桶，只查相邻的 27 个格子
+    void findNearestStatic(const std::vector<float>& invMass, const std::vector<int>& labelCount, const std::vector<glm::vec3>& restPosition,
+                           std::vector<int>& nearestAnchor, std::vector<float>& nearestDistance) const {
+        int n = (int)invMass.size();
+        float range = contactDistance + contactBand;
+        nearestAnchor.assign(n, -1);
+        nearestDistance.assign(n, std::numeric_limits<float>::infinity());
+        if (range <= 0.0f) return;
+
+        auto cellOf = [&](const glm::vec3& p) { return glm::ivec3(glm::floor(p / range)); };
+        auto key = [](const glm::ivec3& c) {
+            return (int64_t(c.x & 0x1fffff) << 42) | (int64_t(c.y & 0x1fffff) << 21) | int64_t(c.z & 0x1fffff);
+        };
+        std::unordered_map<int64_t, std::vector<int>> cells;
+        bool pending = false;
+        for (int i = 0; i < n; i++) {
+            if (invMass[i] == 0.0f) cells[key(cellOf(restPosition[i]))].push_back(i);
+            else if (labelCount[i] == 0) pending = true;
+        }
+        if (!pending || cells.empty()) return;
+
+        #pragma omp parallel for schedule(dynamic, 256) if(n > 4096)
+        for (int i = 0; i < n; i++) {
+            if (invMass[i] == 0.0f || labelCount[i] > 0) continue;
+            glm::ivec3 c = cellOf(restPosition[i]);
+            for (int dx = -1; dx <= 1; dx++)
+                for (int dy = -1; dy <= 1; dy++)
+                    for (int dz = -1; dz <= 1; dz++) {
+                        auto it = cells.find(key(c + glm::ivec3(dx, dy, dz)));
+                        if (it == cells.end()) continue;
+                        for (int s : it->second) {
+                            float d = glm::length(restPosition[i] - restPosition[s]);
+                            if (d < nearestDistance[i]) {
+                                nearestDistance[i] = d;
+                                nearestAnchor[i] = s;
+                            }
+                        }
+                    }
+        }
+    }
+};
+
+#endif
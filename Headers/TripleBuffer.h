@@ -0,0 +1,49 @@
+#pragma once
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/*
+    单生产者 / 单消费者的无锁三缓冲
+    写线程总是写 back，写完 publish() 把 back 和 middle 交换；
+    读线程 update() 时如果 middle 有新数据，就把 front 和 middle 交换，然后读 front。
+    双方只通过一个原子整数交换下标，写线程从不等待读线程，读线程总能拿到最新一份完整的数据。
+*/
+template <typename T>
+class TripleBuffer {
+public:
+    // 写线程：当前可以写的缓冲
+    T& writeBuffer() { return buffers[back]; }
+
+    // 写线程：发布刚写完的缓冲
+    void publish() {
+        int old = middle.exchange(back | DIRTY, std::memory_order_acq_rel);
+        back = old & INDEX_MASK;
+    }
+
+    // 读线程：有新数据时换到最新的一份，返回是否有新数据
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & DIRTY)) return false;
+        int old = middle.exchange(front, std::memory_order_acq_rel);
+        front = old & INDEX_MASK;
+        return true;
+    }
+
+    // 读线程：当前读的缓冲
+    const T& readBuffer() const { return buffers[front]; }
+
+    // 没有线程在读写时（例如模拟线程停止后）直接访问三个缓冲，用于初始化
+    T& buffer(int i) { return buffers[i]; }
+
+private:
+    static constexpr int INDEX_MASK = 3;
+    static constexpr int DIRTY = 4;
+
+    T buffers[3];
+    int back = 0;                  // 只有写线程访问
+    int front = 1;                 // 只有读线程访问
+    std::atomic<int> middle{ 2 };  // 交换用的缓冲下标，DIRTY 表示写线程发布了新数据
+};
+
+#endif
@@ -11,6 +11,9 @@
 #include "Mesh.h"
 #include "Hash.h"
 #include "Simulator.h"
+#include "SimulationThread.h"
+#include "Profiler.h"
+#include "Scene.h"
 
 #include <unordered_set>
 
@@ -104,6 +107,56 @@ void drawParticlesAsSpheres(Shader &shader) {
 }
 
 
+// 各阶段耗时面板：每帧从 profiler 取一次数据，显示最近 120 帧的平均 / 最大值
+// 下面是模拟线程最新一步的工作量统计
+void drawProfilerPanel(const SimCounters& counters) {
+    Profiler& prof = profiler();
+    prof.sample();
+
+    ImGui::Begin("Profiler");
+    bool enabled = prof.enabled.load();
+    if (ImGui::Checkbox("Enabled", &enabled)) prof.enabled.store(enabled);
+
+    if (!prof.isRecording()) {
+        if (ImGui::Button("Record trace")) prof.startRecording();
+    }
+    else {
+        if (ImGui::Button("Stop and save trace.json")) {
+            prof.stopRecording();
+            if (prof.writeChromeTrace("trace.json")) std::cout << "trace saved: trace.json" << std::endl;
+        }
+        ImGui::SameLine();
+        ImGui::Text("%zu events", prof.traceEventCount());
+    }
+
+    ImGui::PlotLines("step ms", prof.historyData(ProfilePhase::Step), Profiler::historySize, prof.historyOffset(),
+                     nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+    ImGui::Text("%-16s %8s %8s %7s", "phase", "avg ms", "max ms", "calls");
+    for (int p = 0; p < Profiler::PhaseCount; p++) {
+        ProfilePhase phase = (ProfilePhase)p;
+        std::string name = std::string(2 * profilePhaseDepth(phase), ' ') + profilePhaseName(phase);
+        ImGui::Text("%-16s %8.3f %8.3f %7.1f", name.c_str(), prof.averageMs(phase), prof.maxMs(phase), prof.averageCalls(phase));
+    }
+
+    ImGui::Separator();
+    ImGui::Text("substeps: %d, constraint iterations: %d", counters.subSteps, counters.iterations);
+    ImGui::Text("neighbor pairs: %lld (adjIds %.1f%% of %lld)", counters.neighborPairs, 100.0f * counters.adjFill(), counters.adjCapacity);
+    ImGui::Text("max neighbors: %d, rebuilds this step: %d", counters.maxNeighbors, counters.neighborRebuilds);
+    ImGui::Text("contacts: %lld of %lld candidates", counters.contacts, counters.contactCandidates);
+    ImGui::Text("tether corrections: %lld (%lld tethers)", counters.tetherCorrections, counters.tethers);
+    if (counters.factorizations > 0 || counters.factorizationFailures > 0)
+        ImGui::Text("PD factorizations: %d (failed %d), envelope %lld", counters.factorizations, counters.factorizationFailures, counters.factorEnvelope);
+    ImGui::Text("stretch error: max %.4f, rms %.4f", counters.stretchErrorMax, counters.stretchErrorRms);
+
+    float histogram[SimCounters::histogramBins];
+    for (int b = 0; b < SimCounters::histogramBins; b++) histogram[b] = (float)counters.neighborHistogram[b];
+    ImGui::PlotHistogram("neighbors / particle", histogram, SimCounters::histogramBins, 0,
+                         "bins of 4, last = more", 0.0f, FLT_MAX, ImVec2(0, 60));
+    ImGui::End();
+}
+
+
 int main() {
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -168,35 +221,13 @@ int main() {
 
 
      // 合并所有的顶点
-    for (auto &model : models)
-    {
-        bool isStaticModel = (model.name == "Models/maoyi/qiu.obj");
-        std::cout << "Model name: " << model.name << std::endl;
-        for (auto &mesh : model.meshes)
-        {
-            for (auto &vertex : mesh.vertices)
-            {
-                if(isStaticModel){
-                    //vertex.mass = 0.0f; // 静态模型的顶点质量设置为很大，避免移动
-                    staticParticles.insert(&vertex);
-                }
-                allParticles.push_back(&vertex);
-            }
-        }
-        for(auto &edge : model.edgeList){
-            edges.push_back(&edge);
-        }
-        for(auto &bendingEdge : model.bendingEdges){
-            bendingEdges.push_back(&bendingEdge);
-        }
-        printf("edge size: %zu\n", edges.size());
-    }
+    gatherParticles(models, allParticles, staticParticles, edges, bendingEdges);
 
 
 
     // 通过所有的顶点构建哈希空间
     //Hash hash(allParticles.size());
-    Hash hash(allParticles.size(), &staticParticles);
+    Hash hash(allParticles.size());
 
     static std::string selectedFile = "Models/lino/YIFU1.obj";
 
@@ -205,6 +236,18 @@ int main() {
 
     // 初始化 simulator
     Simulator simulator(allParticles, edges, bendingEdges, staticParticles, models, hash);
+    simulator.syncVertices = false; // 渲染只读模拟线程发布的快照
+    simulator.adaptiveSubSteps = true; // 子步数按速度在 [2, 10] 之间选
+    simulator.iterCount = 3;           // 误差大时最多迭代 3 次
+    simulator.iterationTolerance = 0.01f;
+    printf("distance kernel: %s\n", DistanceKernel::isaName(simulator.simdIsa));
+
+    // 模拟在独立线程上以固定频率运行，渲染线程每帧取最新的位置快照
+    SimulationThread simThread(simulator);
+    simThread.timestep.maxStepsPerFrame = 4; // 跟不上时最多连走 4 步，多出来的时间丢掉
+    std::vector<glm::vec3> renderPositions;  // 插值后的粒子位置
+
+    lastFrame = (float)glfwGetTime(); // 否则第一帧的 deltaTime 是程序启动到现在的全部时间
 
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = (float)glfwGetTime();
@@ -230,15 +273,18 @@ int main() {
         ImGui::Begin("Preme SPAZIO per disattivare camera");
 
         ImGui::Text("FPS: %d", frame);
+        ImGui::Text("Sim step: %.2f ms (dropped %lld)", simThread.lastStepMs(), simThread.droppedSteps());
 
         if(!start){
             if(ImGui::Button("Start simulate")){
                 start = !start;
+                simThread.start();
             }
         }
         if(start){
             if(ImGui::Button("End simulate")){
                 start = !start;
+                simThread.stop();
             }
         }
 
@@ -269,7 +315,16 @@ int main() {
 
                 //ModelLoaded.cleanup();
                 //ModelLoaded = Model(selectedFile);
-                models.push_back(Model(selectedFile, 0));
+
+                // 模拟线程还在读写 models 和 simulator，先停下来，重建完再继续
+                simThread.stop();
+                models.emplace_back(selectedFile, 0);
+
+                // Model 只会被移动，已有模型的顶点指针不受影响；重新收集粒子并重建求解器
+                gatherParticles(models, allParticles, staticParticles, edges, bendingEdges);
+                hash = Hash(allParticles.size());
+                simulator.rebuild();
+                if(start) simThread.start();
             }
             else {
                 selectedFile = "No file selected.";
@@ -288,6 +343,8 @@ int main() {
         ImGui::Text("Current Value: %.3f", modelSize); // ��ʾ��ǰֵ
         ImGui::End();
 
+        drawProfilerPanel(simThread.counters());
+
         processInput(window);
 
         // background
@@ -295,16 +352,17 @@ int main() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // simulator
-        if(start){
+        // 模拟在 simThread 上以固定步长运行（10 substeps / step），这里每帧取最新快照，按时间插值后上传位置和法线
+        simThread.update();
+        if(start && simThread.interpolatedPositions(renderPositions)){
             //models[0].simulate(deltaTime);
             //simulator.step(deltaTime);
-
-            simulator.simulate(deltaTime, 10); // 10 substeps per frame
             //simulator.substep(deltaTime);
 
-            for(Model m : models){
+            ProfileScope scope(ProfilePhase::GpuUpload);
+            for(Model& m : models){
                 for(unsigned int i = 0; i < m.meshes.size(); i++){
-                    m.meshes[i].updateVertexPositions();
+                    m.meshes[i].updateDynamicVertices(renderPositions);
                 }
             }
             // for(unsigned int i = 0; i < models[0].meshes.size(); i++){
@@ -362,6 +420,7 @@ int main() {
         glfwPollEvents();
     }
 
+    simThread.stop();
     glfwTerminate();
 
     return 0;
@@ -0,0 +1,185 @@
+// 求解器 benchmark：固定 dt、固定子步数的场景，统计每个阶段的 ns / 粒子 / 子步，输出 JSON
+// 用法: ClothSimBenchmark [--frames N] [--warmup N] [--substeps N] [--iters N] [--tol 误差] [--adaptive] [--jacobi | --pd] [--no-tethers] [--dt 秒] [--json 文件] [--simd scalar|sse|avx2|neon] [--scene 模型.obj | gridN | gridN-pinned] ...
+// 不指定 --scene 时运行默认场景：nuSeY.obj、s.obj、一条边固定的 32/64/128 方形布料
+// gridN 是自由下落的布料，边长约束几乎不用修正，也没有静止粒子；gridN-pinned 挂在一条边上，约束、挂接约束和碰撞都有实际的工作量
+
+#include "Model.h"
+#include "Mesh.h"
+#include "Hash.h"
+#include "Simulator.h"
+#include "Scene.h"
+
+#include <unordered_set>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <omp.h>
+
+struct BenchConfig {
+    int frames = 120;
+    int warmup = 10;
+    int subSteps = 10;
+    int iterations = 1;     // 每个子步的约束迭代次数
+    float tolerance = 0.0f; // 迭代提前结束的相对误差，0 为固定迭代次数
+    bool adaptiveSubSteps = false; // 按速度选择子步数，subSteps 为上限
+    bool tethers = true; // 挂接到静止粒子的长程约束
+    SolverMode solver = SolverMode::GaussSeidel; // --jacobi / --pd 切换求解方式
+    float deltaTime = 1.0f / 60.0f;
+    DistanceKernel::Isa simd = DistanceKernel::detect();
+};
+
+// 运行一个场景，返回该场景的 JSON 对象
+std::string runScene(const std::string& scene, const BenchConfig& config) {
+    std::vector<Model> models;
+    std::vector<Vertex_H*> allParticles;
+    std::unordered_set<Vertex_H*> staticParticles;
+    std::vector<Edge*> edges;
+    std::vector<Edge*> bendingEdges;
+
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    if (scene.compare(0, 4, "grid") == 0) {
+        models.push_back(makeClothGrid(atoi(scene.c_str() + 4)));
+        if (scene.size() > 7 && scene.compare(scene.size() - 7, 7, "-pinned") == 0) pinClothGridEdge(models.back());
+    } else {
+        models.emplace_back(scene, 0);
+    }
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+
+    gatherParticles(models, allParticles, staticParticles, edges, bendingEdges);
+    if (allParticles.empty()) {
+        std::cout << "No particles loaded for scene " << scene << std::endl;
+        return "";
+    }
+
+    Hash hash(allParticles.size());
+    Simulator simulator(allParticles, edges, bendingEdges, staticParticles, models, hash);
+    simulator.simdIsa = config.simd;
+    simulator.iterCount = config.iterations;
+    simulator.iterationTolerance = config.tolerance;
+    simulator.adaptiveSubSteps = config.adaptiveSubSteps;
+    simulator.useTethers = config.tethers;
+    simulator.solverMode = config.solver;
+    printf("distance kernel: %s\n", DistanceKernel::isaName(simulator.simdIsa));
+
+    for (int f = 0; f < config.warmup; f++) {
+        simulator.simulate(config.deltaTime, config.subSteps);
+    }
+    simulator.timings.reset();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    long long iterations = 0;
+    for (int f = 0; f < config.frames; f++) {
+        simulator.simulate(config.deltaTime, config.subSteps);
+        iterations += simulator.counters.iterations;
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    const PhaseTimings& t = simulator.timings;
+    double samples = double(allParticles.size()) * double(t.subSteps > 0 ? t.subSteps : 1); // 粒子 * 子步
+    double total = t.predict + t.hash + t.ground + t.constraints + t.collisions + t.velocity + t.sync;
+
+    double iterationSamples = double(allParticles.size()) * double(iterations > 0 ? iterations : 1); // 粒子 * 约束迭代
+    const SimCounters& c = simulator.counters;
+    printf("%-28s %7zu particles  %8.3f ms/frame  %7.2f ns/particle/substep  stretch error max %.4f rms %.4f\n",
+           scene.c_str(), allParticles.size(), totalMs / config.frames, total / samples,
+           c.stretchErrorMax, c.stretchErrorRms);
+    // 不同求解方式每次迭代的代价差别很大（Projective Dynamics 每次迭代要把整个 L 读两遍），同样的误差下要比较的是迭代次数 * 每次迭代的代价
+    printf("%-28s constraints %.2f ns/particle/iteration", "", t.constraints / iterationSamples);
+    if (c.factorizations > 0) printf(", factorizations %d, L envelope %lld (%.1f per particle)", c.factorizations, c.factorEnvelope, double(c.factorEnvelope) / allParticles.size());
+    printf("\n");
+
+    std::ostringstream json;
+    json.precision(4);
+    json << std::fixed;
+    json << "    {\n"
+         << "      \"scene\": \"" << scene << "\",\n"
+         << "      \"particles\": " << allParticles.size() << ",\n"
+         << "      \"edges\": " << edges.size() << ",\n"
+         << "      \"bendingEdges\": " << bendingEdges.size() << ",\n"
+         << "      \"loadMs\": " << loadMs << ",\n"
+         << "      \"msPerFrame\": " << totalMs / config.frames << ",\n"
+         << "      \"neighborRebuildsPerFrame\": " << double(t.neighborRebuilds) / config.frames << ",\n"
+         << "      \"subStepsPerFrame\": " << double(t.subSteps) / config.frames << ",\n"
+         << "      \"iterationsPerFrame\": " << double(iterations) / config.frames << ",\n"
+         << "      \"constraintNsPerParticleIteration\": " << t.constraints / iterationSamples << ",\n"
+         << "      \"factorizations\": " << c.factorizations << ",\n"
+         << "      \"factorEnvelope\": " << c.factorEnvelope << ",\n"
+         << "      \"stretchErrorMax\": " << c.stretchErrorMax << ",\n"
+         << "      \"stretchErrorRms\": " << c.stretchErrorRms << ",\n"
+         << "      \"nsPerParticleSubstep\": {\n"
+         << "        \"predict\": " << t.predict / samples << ",\n"
+         << "        \"hash\": " << t.hash / samples << ",\n"
+         << "        \"ground\": " << t.ground / samples << ",\n"
+         << "        \"constraints\": " << t.constraints / samples << ",\n"
+         << "        \"collisions\": " << t.collisions / samples << ",\n"
+         << "        \"velocity\": " << t.velocity / samples << ",\n"
+         << "        \"sync\": " << t.sync / samples << ",\n"
+         << "        \"total\": " << total / samples << "\n"
+         << "      }\n"
+         << "    }";
+    return json.str();
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    std::string jsonPath = "benchmark.json";
+    std::vector<std::string> scenes;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) config.frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--warmup") && i + 1 < argc) config.warmup = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--substeps") && i + 1 < argc) config.subSteps = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--iters") && i + 1 < argc) config.iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--tol") && i + 1 < argc) config.tolerance = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--adaptive")) config.adaptiveSubSteps = true;
+        else if (!strcmp(argv[i], "--no-tethers")) config.tethers = false;
+        else if (!strcmp(argv[i], "--jacobi")) config.solver = SolverMode::Jacobi;
+        else if (!strcmp(argv[i], "--pd")) config.solver = SolverMode::ProjectiveDynamics;
+        else if (!strcmp(argv[i], "--dt") && i + 1 < argc) config.deltaTime = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc) jsonPath = argv[++i];
+        else if (!strcmp(argv[i], "--scene") && i + 1 < argc) scenes.push_back(argv[++i]);
+        else if (!strcmp(argv[i], "--simd") && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (!strcmp(name, "scalar")) config.simd = DistanceKernel::Isa::Scalar;
+            else if (!strcmp(name, "sse")) config.simd = DistanceKernel::Isa::SSE;
+            else if (!strcmp(name, "avx2") && DistanceKernel::detect() == DistanceKernel::Isa::AVX2) config.simd = DistanceKernel::Isa::AVX2;
+            else if (!strcmp(name, "neon") && DistanceKernel::detect() == DistanceKernel::Isa::NEON) config.simd = DistanceKernel::Isa::NEON;
+        }
+    }
+    if (config.frames <= 0) config.frames = 1;
+    if (scenes.empty()) {
+        scenes = { "Models/maoyi/nuSeY.obj", "Models/maoyi/s.obj", "grid32-pinned", "grid64-pinned", "grid128-pinned" };
+    }
+
+    std::vector<std::string> results;
+    for (const std::string& scene : scenes) {
+        std::string result = runScene(scene, config);
+        if (!result.empty()) results.push_back(result);
+    }
+
+    std::ofstream out(jsonPath);
+    out << "{\n"
+        << "  \"threads\": " << omp_get_max_threads() << ",\n"
+        << "  \"frames\": " << config.frames << ",\n"
+        << "  \"warmup\": " << config.warmup << ",\n"
+        << "  \"substeps\": " << config.subSteps << ",\n"
+        << "  \"iterations\": " << config.iterations << ",\n"
+        << "  \"tolerance\": " << config.tolerance << ",\n"
+        << "  \"adaptiveSubSteps\": " << (config.adaptiveSubSteps ? "true" : "false") << ",\n"
+        << "  \"tethers\": " << (config.tethers ? "true" : "false") << ",\n"
+        << "  \"solver\": \"" << solverModeName(config.solver) << "\",\n"
+        << "  \"kernel\": \"" << DistanceKernel::isaName(config.simd) << "\",\n"
+        << "  \"dt\": " << config.deltaTime << ",\n"
+        << "  \"scenes\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        out << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    std::cout << "Results written to " << jsonPath << std::endl;
+    return 0;
+}
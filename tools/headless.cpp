@@ -0,0 +1,284 @@
+// 无窗口的模拟程序：不创建 OpenGL 上下文，只加载模型并跑 Simulator
+// 用法: ClothSimHeadless [--frames N] [--dt 秒] [--substeps N] [--iters N] [--tol 误差] [--adaptive] [--jacobi | --pd] [--no-tethers] [--static 模型] [--trace 文件.json] 模型.obj ...
+//       ClothSimHeadless --check   求解器回归检查，失败时返回非 0
+
+#include "Model.h"
+#include "Mesh.h"
+#include "Hash.h"
+#include "Simulator.h"
+#include "Scene.h"
+#include "Profiler.h"
+
+#include <unordered_set>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+std::vector<Model> models;
+
+std::vector<Vertex_H*> allParticles;                    // 所有粒子（布料 + 衣架）
+std::unordered_set<Vertex_H*> staticParticles;          // 静态粒子（不可移动，如衣架）
+std::vector<Edge*> edges;                               // 用于边长约束
+std::vector<Edge*> bendingEdges;                        // 用于弯曲约束
+
+// 回归检查 (--check)：一条边固定的方形布料自由下摆，检查求解器没有发散、没有漂移、刚度和 compliance 对应
+// 不需要模型文件，退出码为失败的项数
+struct CheckCase {
+    const char* name;
+    SolverMode mode;
+    int iterations;
+    float compliance;     // 边长约束柔度
+    float maxStretchRms;  // 最后一帧边长误差 rms 的上限
+    bool stiff;           // 接近不可伸长时才检查质心不偏、粒子不高过固定边：很软的布料拉伸很大，
+                          // 网格三角形的对角线方向会让它偏向一侧，回弹时末端也会像鞭子一样甩过固定边
+    bool tethers = false; // 打开挂接约束，并检查粒子离固定边不超过布料的长度
+    bool chebyshev = true; // Jacobi 模式是否用 Chebyshev 加速
+    bool hanger = false;   // 不固定布料的边，而是搭在中线下方一根单独的静态横杆上（和布料没有共享的边，像衣架一样）
+};
+
+struct CheckResult {
+    bool finite = true;
+    float pinnedDrift = 0.0f;    // 固定粒子离开初始位置的最大距离
+    float maxRise = 0.0f;        // 粒子高出固定边的最大高度
+    float centroidZ = 0.0f;      // 质心 |z| 的最大值，布料（除三角形对角线外）关于 z = 0 对称
+    float maxReach = 0.0f;       // 粒子到最近固定粒子的最大直线距离
+    float stretchMax = 0.0f;     // 最后一帧的边长误差
+    float stretchRms = 0.0f;
+    float meanStretchRms = 0.0f; // 所有帧边长误差 rms 的平均
+    long long tethers = 0;       // 建立的挂接约束数
+};
+
+CheckResult runCheckScene(const CheckCase& test, int gridSize, int frames, int subSteps) {
+    std::vector<Model> gridModels;
+    gridModels.push_back(makeClothGrid(gridSize));
+    std::string hangerName;
+    if (test.hanger) {
+        gridModels.push_back(makeClothRect(2, gridSize, 0.5f, 20.0f - 0.8f)); // 两排顶点的窄条，比布料低一个 thickness
+        hangerName = gridModels.back().name;
+    } else {
+        pinClothGridEdge(gridModels[0]);
+    }
+
+    std::vector<Vertex_H*> gridParticles;
+    std::unordered_set<Vertex_H*> gridStatic;
+    std::vector<Edge*> gridEdges, gridBending;
+    gatherParticles(gridModels, gridParticles, gridStatic, gridEdges, gridBending, hangerName);
+    float pinY = 0.0f;
+    std::vector<glm::vec3> pinned;
+    for (Vertex_H* v : gridParticles) {
+        if (v->mass != 0.0f && !gridStatic.count(v)) continue;
+        pinned.push_back(v->Position);
+        pinY = v->Position.y;
+    }
+    Hash gridHash(gridParticles.size());
+    Simulator sim(gridParticles, gridEdges, gridBending, gridStatic, gridModels, gridHash);
+    sim.stretchCompliance = test.compliance;
+    sim.solverMode = test.mode;
+    sim.iterCount = test.iterations;
+    sim.useTethers = test.tethers;
+    sim.jacobi.chebyshev = test.chebyshev;
+    sim.reorderInterval = 50; // 检查期间重排两次，覆盖重排后各求解器的重映射
+    sim.rebuild();
+
+    CheckResult result;
+    const ParticleState& p = sim.particles;
+    for (int f = 0; f < frames; f++) {
+        sim.simulate(1.0f / 60.0f, subSteps);
+
+        // 每帧都检查，整个摆动过程中出过问题就算失败
+        glm::vec3 centroid(0.0f);
+        for (size_t i = 0; i < p.size(); i++) {
+            const glm::vec3& x = p.position[i];
+            if (!std::isfinite(x.x) || !std::isfinite(x.y) || !std::isfinite(x.z)) result.finite = false;
+            centroid += x;
+            result.maxRise = std::max(result.maxRise, x.y - pinY);
+            if (test.tethers) {
+                float reach = 1e30f;
+                for (const glm::vec3& x0 : pinned) reach = std::min(reach, glm::length(x - x0));
+                result.maxReach = std::max(result.maxReach, reach);
+            }
+            if (p.invMass[i] == 0.0f) {
+                float drift = 1e30f;
+                for (const glm::vec3& x0 : pinned) drift = std::min(drift, glm::length(x - x0));
+                result.pinnedDrift = std::max(result.pinnedDrift, drift);
+            }
+        }
+        result.centroidZ = std::max(result.centroidZ, std::abs(centroid.z / float(p.size())));
+        result.meanStretchRms += sim.counters.stretchErrorRms / float(frames);
+        if (!result.finite) break;
+    }
+    result.tethers = sim.counters.tethers;
+    result.stretchMax = sim.counters.stretchErrorMax;
+    result.stretchRms = sim.counters.stretchErrorRms;
+    return result;
+}
+
+int runChecks() {
+    const int gridSize = 32, frames = 240, subSteps = 5; // 240 帧：布料摆到最低点再摆回来
+    const float clothLength = 0.5f * (gridSize - 1);     // makeClothGrid 默认间距 0.5
+    const CheckCase cases[] = {
+        { "gauss-seidel stiff",    SolverMode::GaussSeidel, 10, 0.0f,  0.005f, true },
+        { "gauss-seidel stiff 2",  SolverMode::GaussSeidel, 2,  0.0f,  0.01f,  true },
+        { "gauss-seidel 1e-3",     SolverMode::GaussSeidel, 30, 1e-3f, 0.4f,   false },
+        { "jacobi stiff",          SolverMode::Jacobi,      10, 0.0f,  0.01f,  true },
+        { "jacobi 1e-3",           SolverMode::Jacobi,      30, 1e-3f, 0.4f,   false },
+        { "projective stiff",      SolverMode::ProjectiveDynamics, 10, 0.0f,  0.01f, true },
+        { "projective 1e-3",       SolverMode::ProjectiveDynamics, 30, 1e-3f, 0.4f,  false },
+        { "gauss-seidel tethers",  SolverMode::GaussSeidel, 10, 1e-3f, 0.05f,  false, true },
+        { "jacobi tethers",        SolverMode::Jacobi,      10, 1e-3f, 0.05f,  false, true },
+        { "projective tethers",    SolverMode::ProjectiveDynamics, 10, 1e-3f, 0.05f, false, true },
+    };
+
+    int failures = 0;
+    auto expect = [&](bool ok, const char* name, const char* what) {
+        if (!ok) {
+            printf("  FAIL %s: %s\n", name, what);
+            failures++;
+        }
+    };
+    auto run = [&](const CheckCase& test) {
+        CheckResult r = runCheckScene(test, gridSize, frames, subSteps);
+        printf("%-24s stretch error max %.4f rms %.4f (mean %.4f), centroid z %.4f, rise %.4f, pinned drift %.2g, reach %.3f\n",
+               test.name, r.stretchMax, r.stretchRms, r.meanStretchRms, r.centroidZ, r.maxRise, r.pinnedDrift, r.maxReach);
+        expect(r.finite, test.name, "non-finite position");
+        expect(r.pinnedDrift < 1e-4f, test.name, "pinned particle moved");
+        expect(!test.stiff || r.maxRise < 0.25f, test.name, "particle rose above the pinned edge");
+        expect(!test.stiff || r.centroidZ < 0.25f, test.name, "centroid drifted sideways");
+        expect(r.stretchRms < test.maxStretchRms, test.name, "stretch error too large");
+        expect(!test.tethers || r.maxReach < 1.01f * clothLength, test.name, "tethered particle beyond the cloth length");
+        return r;
+    };
+    for (const CheckCase& test : cases) run(test);
+
+    // Chebyshev 加速：和 viewer 一样每个子步迭代 3 次，边长误差应该明显低于不加速的 Jacobi
+    // 3 次迭代离不可伸长还差得远，不检查质心和高度。chebyshevDelay 为 2 时只有最后一次迭代加速，误差约为不加速的 0.7 倍，
+    // 为 1 时约 0.5 倍
+    CheckCase accelerated = { "jacobi chebyshev",    SolverMode::Jacobi, 3, 0.0f, 0.02f, false };
+    CheckCase plain = accelerated;
+    plain.name = "jacobi no chebyshev";
+    plain.chebyshev = false;
+    CheckResult withChebyshev = run(accelerated);
+    CheckResult withoutChebyshev = run(plain);
+    expect(withChebyshev.meanStretchRms < 0.6f * withoutChebyshev.meanStretchRms, accelerated.name, "no lower stretch error than plain Jacobi");
+
+    // 搭在单独的静态横杆上：布料和静止粒子不连通，挂接约束从接触横杆的一圈粒子算起，应该建立起来并减小拉伸
+    CheckCase hanging = { "hanger tethers",      SolverMode::GaussSeidel, 3, 1e-3f, 0.15f, false, true };
+    hanging.hanger = true;
+    CheckCase loose = hanging;
+    loose.name = "hanger no tethers";
+    loose.tethers = false;
+    loose.maxStretchRms = 1.0f;
+    CheckResult withTethers = run(hanging);
+    CheckResult withoutTethers = run(loose);
+    expect(withTethers.tethers > 0, hanging.name, "no tethers to a disconnected static model");
+    expect(withTethers.meanStretchRms < 0.8f * withoutTethers.meanStretchRms, hanging.name, "no lower stretch error than without tethers");
+    printf("check: %d failure(s)\n", failures);
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    int frames = 300;
+    float deltaTime = 1.0f / 60.0f;
+    int subSteps = 10;
+    int iterations = 1;
+    float tolerance = 0.0f;       // 迭代提前结束的相对误差，0 为固定迭代次数
+    bool adaptiveSubSteps = false; // 按速度选择子步数，--substeps 为上限
+    bool tethers = true;           // 挂接到静止粒子的长程约束
+    SolverMode solver = SolverMode::GaussSeidel; // --jacobi / --pd 切换求解方式
+    std::string staticModel = "Models/maoyi/qiu.obj";
+    std::string tracePath; // 非空时录制各阶段耗时，结束后写成 Chrome trace
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--dt") && i + 1 < argc) deltaTime = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--substeps") && i + 1 < argc) subSteps = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--iters") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--tol") && i + 1 < argc) tolerance = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--adaptive")) adaptiveSubSteps = true;
+        else if (!strcmp(argv[i], "--no-tethers")) tethers = false;
+        else if (!strcmp(argv[i], "--jacobi")) solver = SolverMode::Jacobi;
+        else if (!strcmp(argv[i], "--pd")) solver = SolverMode::ProjectiveDynamics;
+        else if (!strcmp(argv[i], "--static") && i + 1 < argc) staticModel = argv[++i];
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc) tracePath = argv[++i];
+        else if (!strcmp(argv[i], "--check")) return runChecks();
+        else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) paths.push_back("Models/maoyi/nuSeY.obj");
+
+    if (!tracePath.empty()) {
+        profiler().enabled.store(true);
+        profiler().startRecording();
+    }
+
+    int vertexCount = 0;
+    for (const std::string& path : paths) {
+        models.emplace_back(path, vertexCount);
+        for (auto& mesh : models.back().meshes) {
+            vertexCount += mesh.vertices.size();
+        }
+    }
+
+    gatherParticles(models, allParticles, staticParticles, edges, bendingEdges, staticModel);
+    if (allParticles.empty()) {
+        std::cout << "No particles loaded" << std::endl;
+        return -1;
+    }
+    printf("particles: %zu, static: %zu, edges: %zu, bending edges: %zu\n",
+           allParticles.size(), staticParticles.size(), edges.size(), bendingEdges.size());
+
+    Hash hash(allParticles.size());
+    Simulator simulator(allParticles, edges, bendingEdges, staticParticles, models, hash);
+    simulator.iterCount = iterations;
+    simulator.iterationTolerance = tolerance;
+    simulator.adaptiveSubSteps = adaptiveSubSteps;
+    simulator.useTethers = tethers;
+    simulator.solverMode = solver;
+    printf("distance kernel: %s\n", DistanceKernel::isaName(simulator.simdIsa));
+
+    double total = 0.0, minTime = 1e30, maxTime = 0.0;
+    for (int f = 0; f < frames; f++) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        simulator.simulate(deltaTime, subSteps);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        total += ms;
+        minTime = std::min(minTime, ms);
+        maxTime = std::max(maxTime, ms);
+        const SimCounters& c = simulator.counters;
+        printf("frame %d: %.3f ms, substeps %d, iterations %d, contacts %lld, stretch error max %.4f rms %.4f\n",
+               f, ms, c.subSteps, c.iterations, c.contacts, c.stretchErrorMax, c.stretchErrorRms);
+    }
+
+    if (frames > 0) {
+        printf("frames: %d, substeps: %d%s, iterations: %d, tolerance: %g, solver: %s, dt: %.4f\n", frames, subSteps, adaptiveSubSteps && solver != SolverMode::ProjectiveDynamics ? " (adaptive, max)" : "",
+               iterations, tolerance, solverModeName(solver), deltaTime);
+        printf("avg: %.3f ms, min: %.3f ms, max: %.3f ms\n", total / frames, minTime, maxTime);
+        printf("neighbor rebuilds: %lld\n", simulator.timings.neighborRebuilds);
+        if (simulator.counters.factorizations > 0)
+            printf("factorizations: %d (failed %d), envelope %lld\n", simulator.counters.factorizations,
+                   simulator.counters.factorizationFailures, simulator.counters.factorEnvelope);
+
+        const SimCounters& c = simulator.counters;
+        printf("neighbor pairs: %lld, adjIds fill: %.1f%% of %lld, max neighbors: %d\n",
+               c.neighborPairs, 100.0f * c.adjFill(), c.adjCapacity, c.maxNeighbors);
+        printf("neighbors per particle:");
+        for (int b = 0; b < SimCounters::histogramBins; b++) {
+            int lo = b * SimCounters::histogramBinWidth;
+            if (b + 1 < SimCounters::histogramBins) printf(" [%d-%d]:%d", lo, lo + SimCounters::histogramBinWidth - 1, c.neighborHistogram[b]);
+            else printf(" [%d+]:%d", lo, c.neighborHistogram[b]);
+        }
+        printf("\n");
+    }
+    if (!tracePath.empty()) {
+        profiler().stopRecording();
+        size_t events = profiler().traceEventCount();
+        if (profiler().writeChromeTrace(tracePath)) printf("trace: %s (%zu events)\n", tracePath.c_str(), events);
+        else printf("failed to write trace: %s\n", tracePath.c_str());
+    }
+    return 0;
+}